@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include "bench_corpus.hpp"
+#include "regex_utils.hpp"
+
+// Counts heap allocations made by one search or find over a generated tree.
+// The counts should follow the number of matches, not the number of files
+// or lines scanned. Accepts the same `key=value` corpus overrides as
+// e2e_bench.
+
+static std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t size){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+static std::size_t countLines(const CorpusStats& corpus){
+    std::size_t lines = 0;
+    for(const auto &path : corpus.textFiles){
+        std::ifstream in(path, std::ios::binary);
+        lines += static_cast<std::size_t>(std::count(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>(), '\n'));
+    }
+    return lines;
+}
+
+int main(int argc, char** argv){
+    CorpusSpec spec = parseCorpusSpec(argc, argv);
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "filecli-alloc-bench";
+    std::cout << "[";
+    bool first = true;
+    for(double density : {spec.matchDensity / 10, spec.matchDensity * 10}){
+        CorpusSpec shaped = spec;
+        shaped.matchDensity = density;
+        const CorpusStats corpus = generateCorpus(root, shaped);
+        const std::size_t lines = countLines(corpus);
+
+        auto [matcher, err] = compileRegex(MATCH_TOKEN);
+        if(err != RegexError::Ok) return 1;
+        for(bool asyncRead : {false, true}){
+            SearchConfig config;
+            config.maxGlobalMatches = SIZE_MAX;
+            config.maxMatchesPerFile = SIZE_MAX;
+            config.asyncRead = asyncRead;
+
+            std::size_t before = 0;
+            std::size_t count = 0;
+            {
+                QuietStdout quiet;
+                before = allocations.load();
+                (void)findInFile(MATCH_TOKEN, *matcher, config, root);
+                count = allocations.load() - before;
+            }
+            std::cout << (first ? "\n" : ",\n") << "  {\"bench\": \"search\", \"uring\": " << (asyncRead ? "true" : "false")
+                      << ", \"files\": " << corpus.files << ", \"lines\": " << lines << ", \"matches\": " << corpus.matchLines
+                      << ", \"allocations\": " << count << ", \"per_match\": " << (static_cast<double>(count) / std::max<std::size_t>(1, corpus.matchLines)) << "}";
+            first = false;
+        }
+
+        auto [nameMatcher, nameErr] = compileRegex("file1\\d*\\.txt$");
+        if(nameErr != RegexError::Ok) return 1;
+        FindConfig findConfig;
+        std::size_t found = 0;
+        // The first call builds the tree snapshot; count the second.
+        for(int pass = 0; pass < 2; ++pass){
+            found = 0;
+            std::size_t before = allocations.load();
+            (void)findFilesByName(*nameMatcher, findConfig, [&found](std::vector<std::string_view>& files){ found += files.size(); }, root);
+            if(pass == 1){
+                std::size_t count = allocations.load() - before;
+                std::cout << ",\n  {\"bench\": \"find\", \"files\": " << corpus.files << ", \"found\": " << found << ", \"allocations\": " << count << "}";
+            }
+        }
+    }
+    std::cout << "\n]\n";
+
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    return 0;
+}
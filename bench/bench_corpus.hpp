@@ -0,0 +1,171 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "config.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Shape of a synthetic tree. The same spec and seed always give the same
+// tree. Every line has a `matchDensity` chance of holding MATCH_TOKEN.
+struct CorpusSpec{
+    int depth = 3;
+    int fanout = 4;
+    std::size_t files = 4000;
+    std::size_t meanFileSize = 16 * KB;
+    double sizeSpread = 1.0;
+    double binaryRatio = 0.05;
+    double matchDensity = 0.01;
+    std::uint32_t seed = 42;
+};
+
+struct CorpusStats{
+    std::size_t files = 0;
+    std::size_t binaryFiles = 0;
+    std::size_t bytes = 0;
+    std::size_t matchLines = 0;
+    std::vector<std::filesystem::path> textFiles;
+};
+
+constexpr const char* MATCH_TOKEN = "needleToken";
+
+// Reads `key=value` overrides such as `files=20000 depth=5` from argv.
+inline CorpusSpec parseCorpusSpec(int argc, char** argv){
+    CorpusSpec spec;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if(eq == std::string::npos) continue;
+        std::string key = arg.substr(0, eq);
+        double value = std::atof(arg.c_str() + eq + 1);
+        if(key == "depth") spec.depth = static_cast<int>(value);
+        else if(key == "fanout") spec.fanout = static_cast<int>(value);
+        else if(key == "files") spec.files = static_cast<std::size_t>(value);
+        else if(key == "size") spec.meanFileSize = static_cast<std::size_t>(value);
+        else if(key == "spread") spec.sizeSpread = value;
+        else if(key == "binary") spec.binaryRatio = value;
+        else if(key == "density") spec.matchDensity = value;
+        else if(key == "seed") spec.seed = static_cast<std::uint32_t>(value);
+    }
+    return spec;
+}
+
+inline CorpusStats generateCorpus(const std::filesystem::path& root, const CorpusSpec& spec){
+    static const char* words[] = {"int", "return", "value", "std::string", "if", "for", "while", "config",
+                                  "const", "auto", "{", "}", "(", ")", ";", "result", "index", "buffer"};
+    std::mt19937 rng(spec.seed);
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+
+    std::vector<std::filesystem::path> dirs{root};
+    for(std::size_t level = 0, first = 0; level < static_cast<std::size_t>(spec.depth); ++level){
+        std::size_t last = dirs.size();
+        for(std::size_t d = first; d < last; ++d){
+            for(int f = 0; f < spec.fanout; ++f) dirs.push_back(dirs[d] / ("dir" + std::to_string(f)));
+        }
+        first = last;
+    }
+    for(const auto &dir : dirs) std::filesystem::create_directories(dir, ec);
+
+    // Log-normal sizes keep most files small with a long tail of big ones.
+    const double mu = std::log(static_cast<double>(spec.meanFileSize)) - spec.sizeSpread * spec.sizeSpread / 2;
+    std::lognormal_distribution<double> sizeDist(mu, spec.sizeSpread);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    CorpusStats stats;
+    std::string content;
+    for(std::size_t i = 0; i < spec.files; ++i){
+        std::filesystem::path path = dirs[rng() % dirs.size()] / ("file" + std::to_string(i));
+        std::size_t size = std::min<std::size_t>(static_cast<std::size_t>(sizeDist(rng)), 8 * MB);
+        bool binary = unit(rng) < spec.binaryRatio;
+
+        content.clear();
+        if(binary){
+            path += ".bin";
+            content.push_back('\0');
+            while(content.size() < size) content.push_back(static_cast<char>(rng() & 0xff));
+            ++stats.binaryFiles;
+        }else{
+            path += ".txt";
+            while(content.size() < size){
+                std::size_t wordsInLine = rng() % 12;
+                for(std::size_t w = 0; w < wordsInLine; ++w){
+                    content += words[rng() % (sizeof(words) / sizeof(words[0]))];
+                    content += ' ';
+                }
+                if(unit(rng) < spec.matchDensity){
+                    content += MATCH_TOKEN;
+                    ++stats.matchLines;
+                }
+                content += '\n';
+            }
+            stats.textFiles.push_back(path);
+        }
+        std::ofstream(path, std::ios::binary).write(content.data(), static_cast<std::streamsize>(content.size()));
+        stats.bytes += content.size();
+        ++stats.files;
+    }
+    return stats;
+}
+
+// Sends stdout to /dev/null for the lifetime of the guard so result
+// printing does not dominate end-to-end timings.
+class QuietStdout{
+public:
+    QuietStdout(){
+        std::cout.flush();
+        std::fflush(stdout);
+#if defined(__unix__) || defined(__APPLE__)
+        saved = dup(1);
+        int null = open("/dev/null", O_WRONLY);
+        if(null >= 0){
+            dup2(null, 1);
+            close(null);
+        }
+#endif
+    }
+    ~QuietStdout(){
+        std::cout.flush();
+        std::fflush(stdout);
+#if defined(__unix__) || defined(__APPLE__)
+        if(saved >= 0){
+            dup2(saved, 1);
+            close(saved);
+        }
+#endif
+    }
+    QuietStdout(const QuietStdout&) = delete;
+    QuietStdout& operator=(const QuietStdout&) = delete;
+
+private:
+    int saved = -1;
+};
+
+// `text` as a quoted JSON string.
+inline std::string jsonString(const std::string& text){
+    std::string out = "\"";
+    for(char c : text){
+        if(c == '\\' || c == '"') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+template<typename Fn>
+double timeSeconds(Fn&& fn){
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
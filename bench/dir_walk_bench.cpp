@@ -0,0 +1,64 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "dir_walker.hpp"
+
+// Builds a synthetic tree and walks it with walkTree and with the
+// std::filesystem loop the search walker used before, counting regular files.
+int main(){
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "filecli-walk-bench";
+    const int topDirs = 40;
+    const int subDirs = 10;
+    const int filesPerDir = 200;
+
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    for(int d = 0; d < topDirs; ++d){
+        for(int s = 0; s < subDirs; ++s){
+            std::filesystem::path dir = root / ("d" + std::to_string(d)) / ("s" + std::to_string(s));
+            std::filesystem::create_directories(dir);
+            for(int f = 0; f < filesPerDir; ++f) std::ofstream(dir / ("file" + std::to_string(f) + ".txt")) << "x";
+        }
+    }
+
+    const int rounds = 5;
+    std::size_t walkerFiles = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int r = 0; r < rounds; ++r){
+        walkerFiles = 0;
+        FileError walked = walkTree(root, [&](const WalkEntry &entry){
+            if(entry.isRegularFile()){
+                std::string path = entry.path();
+                walkerFiles += !path.empty();
+            }
+            return WalkAction::Continue;
+        });
+        if(walked != FileError::Ok) return 1;
+    }
+    std::chrono::duration<double> walkerSecs = std::chrono::steady_clock::now() - start;
+
+    std::size_t stdFiles = 0;
+    start = std::chrono::steady_clock::now();
+    for(int r = 0; r < rounds; ++r){
+        stdFiles = 0;
+        for(std::filesystem::recursive_directory_iterator it(root, ec); it != std::filesystem::recursive_directory_iterator(); it.increment(ec)){
+            std::error_code stat_ec;
+            if(!it->is_regular_file(stat_ec)) continue;
+            std::uintmax_t size = it->file_size(stat_ec);
+            if(stat_ec) continue;
+            stdFiles += size != static_cast<std::uintmax_t>(-1);
+        }
+    }
+    std::chrono::duration<double> stdSecs = std::chrono::steady_clock::now() - start;
+
+    std::filesystem::remove_all(root, ec);
+
+    auto rate = [&](std::size_t files, double secs){ return static_cast<double>(files) * rounds / secs; };
+    std::cout << "[\n"
+              << "  {\"walker\": \"walkTree\", \"files\": " << walkerFiles << ", \"files_s\": " << rate(walkerFiles, walkerSecs.count()) << "},\n"
+              << "  {\"walker\": \"std::filesystem\", \"files\": " << stdFiles << ", \"files_s\": " << rate(stdFiles, stdSecs.count()) << "}\n"
+              << "]\n";
+    return 0;
+}
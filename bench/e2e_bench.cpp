@@ -0,0 +1,84 @@
+#include <atomic>
+#include <iostream>
+#include <string>
+#include "bench_corpus.hpp"
+#include "file_utils.hpp"
+#include "line_reader.hpp"
+#include "regex_utils.hpp"
+
+// End-to-end timings of find, search and read over a generated tree.
+// Corpus shape can be overridden with `key=value` arguments, for example
+// `./bench/e2e_bench.exe files=20000 depth=4 binary=0.1 density=0.001`.
+int main(int argc, char** argv){
+    const CorpusSpec spec = parseCorpusSpec(argc, argv);
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "filecli-e2e-bench";
+    const CorpusStats corpus = generateCorpus(root, spec);
+    const double corpusMb = static_cast<double>(corpus.bytes) / MB;
+
+    std::cout << "[\n  {\"bench\": \"corpus\", \"files\": " << corpus.files << ", \"binary_files\": " << corpus.binaryFiles
+              << ", \"mb\": " << corpusMb << ", \"match_lines\": " << corpus.matchLines
+              << ", \"depth\": " << spec.depth << ", \"fanout\": " << spec.fanout << ", \"seed\": " << spec.seed << "}";
+
+    auto [nameMatcher, nameErr] = compileRegex("file1\\d*\\.txt$");
+    if(nameErr != RegexError::Ok) return 1;
+    for(std::size_t threads : {std::size_t(1), defaultThreadCount()}){
+        // Changing the root's mtime makes the next find rebuild its snapshot.
+        std::error_code touchEc;
+        std::filesystem::create_directory(root / ".bench-touch", touchEc);
+        std::filesystem::remove(root / ".bench-touch", touchEc);
+
+        FindConfig config;
+        config.threads = threads;
+        for(const char *phase : {"cold", "warm"}){
+            std::atomic<std::size_t> found{0};
+            double secs = timeSeconds([&]{
+                RegexError err = findFilesByName(*nameMatcher, config, [&found](std::vector<std::string_view>& files){ found += files.size(); }, root);
+                if(err != RegexError::Ok) found = 0;
+            });
+            std::cout << ",\n  {\"bench\": \"find\", \"phase\": \"" << phase << "\", \"threads\": " << threads << ", \"found\": " << found.load()
+                      << ", \"files_s\": " << (static_cast<double>(corpus.files) / secs) << "}";
+        }
+    }
+
+    const char* patterns[] = {MATCH_TOKEN, "needle\\w+", "return\\s+value"};
+    for(const char *pattern : patterns){
+        auto [matcher, err] = compileRegex(pattern);
+        if(err != RegexError::Ok) return 1;
+        SearchConfig config;
+        config.maxGlobalMatches = SIZE_MAX;
+        config.maxMatchesPerFile = SIZE_MAX;
+
+        RegexError result = RegexError::Ok;
+        double secs = 0;
+        {
+            QuietStdout quiet;
+            secs = timeSeconds([&]{ result = findInFile(pattern, *matcher, config, root); });
+        }
+        std::cout << ",\n  {\"bench\": \"search\", \"pattern\": " << jsonString(pattern) << ", \"engine\": " << jsonString(matcher->engineName())
+                  << ", \"ok\": " << (result == RegexError::Ok ? "true" : "false")
+                  << ", \"mb_s\": " << (corpusMb / secs) << ", \"files_s\": " << (static_cast<double>(corpus.files) / secs) << "}";
+    }
+
+    std::size_t readBytes = 0;
+    for(const auto &path : corpus.textFiles){
+        std::error_code sizeEc;
+        readBytes += static_cast<std::size_t>(std::filesystem::file_size(path, sizeEc));
+    }
+    std::size_t readOk = 0;
+    double readSecs = 0;
+    {
+        QuietStdout quiet;
+        readSecs = timeSeconds([&]{
+            for(const auto &path : corpus.textFiles){
+                if(streamFileLines(path.string(), ReadConfig{}) == FileError::Ok) ++readOk;
+            }
+        });
+    }
+    std::cout << ",\n  {\"bench\": \"read\", \"files\": " << corpus.textFiles.size() << ", \"ok\": " << readOk
+              << ", \"mb_s\": " << (static_cast<double>(readBytes) / MB / readSecs)
+              << ", \"files_s\": " << (static_cast<double>(corpus.textFiles.size()) / readSecs) << "}\n]\n";
+
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include "config.hpp"
+#include "literal_scan.hpp"
+
+// Measures the case-insensitive literal kernel against a memcpy of the same
+// buffer, which approximates memory bandwidth.
+int main(){
+    const std::size_t size = 64 * MB;
+    std::string corpus(size, ' ');
+    std::mt19937 rng(99);
+    for(auto &c : corpus){
+        unsigned r = rng() % 64;
+        c = r < 52 ? static_cast<char>((r < 26 ? 'a' : 'A') + r % 26) : (r < 60 ? ' ' : '\n');
+    }
+    std::string copy(size, '\0');
+
+    auto start = std::chrono::steady_clock::now();
+    std::memcpy(copy.data(), corpus.data(), size);
+    std::chrono::duration<double> copySecs = std::chrono::steady_clock::now() - start;
+
+    const char* needles[] = {"TODO", "myFunction", "q"};
+    std::cout << "[\n";
+    bool first = true;
+    for(const char *needle : needles){
+        LiteralFinder finder(needle);
+        std::size_t hits = 0;
+        start = std::chrono::steady_clock::now();
+        for(std::size_t pos = 0; (pos = finder.find(corpus, pos)) != std::string::npos; ++pos) ++hits;
+        std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+
+        if(!first) std::cout << ",\n";
+        first = false;
+        std::cout << "  {\"needle\": \"" << needle << "\", \"kernel\": \"" << literalKernelName()
+                  << "\", \"hits\": " << hits
+                  << ", \"scan_mb_s\": " << (static_cast<double>(size) / MB / secs.count())
+                  << ", \"memcpy_mb_s\": " << (static_cast<double>(size) / MB / copySecs.count()) << "}";
+    }
+    std::cout << "\n]\n";
+    return 0;
+}
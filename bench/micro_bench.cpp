@@ -0,0 +1,140 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bench_corpus.hpp"
+#include "flag_utils.hpp"
+#include "pattern_cache.hpp"
+#include "regex_utils.hpp"
+
+// Per-operation costs of pattern compilation and flag parsing, and line
+// scanning throughput of compiled matchers over an in-memory buffer.
+static void printResult(bool& first, const std::string& body){
+    if(!first) std::cout << ",\n";
+    first = false;
+    std::cout << "  {" << body << "}";
+}
+
+int main(){
+    bool first = true;
+    std::cout << "[\n";
+
+    const char* patterns[] = {"TODO", "myFunction\\(", "std::\\w+", "^\\s*return\\s+\\d+;", "(foo|bar)baz[0-9]{2,4}", "(?=look)ahead"};
+    // Capacity 0 measures a full compile on every call, the default a cache hit.
+    for(std::size_t capacity : {std::size_t(0), PATTERN_CACHE_CAPACITY}){
+        patternCache().setCapacity(capacity);
+        for(const char *pattern : patterns){
+            const int iterations = 2000;
+            std::size_t compiled = 0;
+            std::string engine;
+            double secs = timeSeconds([&]{
+                for(int i = 0; i < iterations; ++i){
+                    auto [matcher, err] = compileRegex(pattern);
+                    if(err != RegexError::Ok) continue;
+                    ++compiled;
+                    if(engine.empty()) engine = matcher->engineName();
+                }
+            });
+            printResult(first, "\"bench\": \"compileRegex\", \"pattern\": " + jsonString(pattern) + ", \"engine\": " + jsonString(engine) +
+                        ", \"cache\": " + (capacity ? "true" : "false") +
+                        ", \"ok\": " + std::to_string(compiled) + ", \"ns_per_op\": " + std::to_string(secs * 1e9 / iterations));
+        }
+    }
+
+    const char* flagLines[] = {"--max-file-size=10MB", "--mgm=100 --mmpf=5", "--max-depth=3 --threads=4 --mfs=512KB --index"};
+    for(const char *line : flagLines){
+        const int iterations = 200000;
+        std::size_t applied = 0;
+        // Building a SearchConfig asks the OS for the core count, which
+        // would swamp the parse itself.
+        SearchConfig config;
+        double secs = timeSeconds([&]{
+            for(int i = 0; i < iterations; ++i){
+                applied += parseFlags(line, SEARCH_FLAGS, config) == FlagError::Ok;
+            }
+        });
+        printResult(first, "\"bench\": \"parseFlags\", \"flags\": " + jsonString(line) + ", \"applied\": " +
+                    std::to_string(applied) + ", \"ns_per_op\": " + std::to_string(secs * 1e9 / iterations));
+    }
+
+    // File name filters against a regex doing the same job, per name tested.
+    std::vector<std::string> names;
+    {
+        std::mt19937 rng(CorpusSpec().seed);
+        static const char* stems[] = {"main", "parser", "config_test", "README", "index", "Makefile", "widget", "util"};
+        static const char* exts[] = {".cpp", ".hpp", ".h", ".py", ".md", ".o", ".json", ".txt", "", ".tar.gz"};
+        for(int i = 0; i < 4096; ++i){
+            names.push_back(std::string(stems[rng() % 8]) + std::to_string(i % 7) + exts[rng() % 10]);
+        }
+    }
+    struct FilterCase{ const char *flags; const char *regex; };
+    const FilterCase filters[] = {
+        {"--type=cpp", "\\.(cpp|cc|cxx|c\\+\\+|hpp|hh|hxx|h\\+\\+|h|inl|ipp)$"},
+        {"--glob=*_test0.cpp --glob=*.tar.gz", "(_test0\\.cpp|\\.tar\\.gz)$"},
+        {"--glob=*[0-3].h", "[0-3]\\.h$"},
+    };
+    for(const auto &filter : filters){
+        SearchConfig config;
+        if(parseFlags(filter.flags, SEARCH_FLAGS, config) != FlagError::Ok) return 1;
+        auto [matcher, regErr] = compileRegex(filter.regex);
+        if(regErr != RegexError::Ok) return 1;
+
+        const int rounds = 200;
+        std::size_t accepted = 0;
+        double filterSecs = timeSeconds([&]{
+            for(int r = 0; r < rounds; ++r){
+                for(const auto &name : names) accepted += config.names.acceptsFile(name);
+            }
+        });
+        std::size_t regexAccepted = 0;
+        double regexSecs = timeSeconds([&]{
+            for(int r = 0; r < rounds; ++r){
+                for(const auto &name : names) regexAccepted += matcher->search(name);
+            }
+        });
+        double tested = static_cast<double>(rounds) * static_cast<double>(names.size());
+        printResult(first, "\"bench\": \"nameFilter\", \"flags\": " + jsonString(filter.flags) + ", \"accepted\": " + std::to_string(accepted / rounds) +
+                    ", \"regex_accepted\": " + std::to_string(regexAccepted / rounds) + ", \"ns_per_name\": " + std::to_string(filterSecs * 1e9 / tested) +
+                    ", \"regex_ns_per_name\": " + std::to_string(regexSecs * 1e9 / tested));
+    }
+
+    // 32MB of corpus-like lines with a match on about one line in a hundred.
+    std::string text;
+    {
+        std::mt19937 rng(CorpusSpec().seed);
+        static const char* words[] = {"int", "return", "value", "std::string", "if", "for", "const", "auto", "{", "}", ";"};
+        while(text.size() < 32 * MB){
+            for(std::size_t w = rng() % 12; w > 0; --w){
+                text += words[rng() % (sizeof(words) / sizeof(words[0]))];
+                text += ' ';
+            }
+            if(rng() % 100 == 0) text += MATCH_TOKEN;
+            text += '\n';
+        }
+    }
+
+    const char* scanPatterns[] = {MATCH_TOKEN, "std::\\w+", "return\\s+\\w+;"};
+    for(const char *pattern : scanPatterns){
+        auto [matcher, err] = compileRegex(pattern);
+        if(err != RegexError::Ok) return 1;
+        std::size_t lines = 0;
+        std::size_t hits = 0;
+        double secs = timeSeconds([&]{
+            const char *pos = text.data();
+            const char *end = pos + text.size();
+            while(pos < end){
+                const char *nl = static_cast<const char*>(std::memchr(pos, '\n', static_cast<std::size_t>(end - pos)));
+                if(!nl) nl = end;
+                hits += matcher->search(std::string_view(pos, static_cast<std::size_t>(nl - pos)));
+                ++lines;
+                pos = nl + 1;
+            }
+        });
+        printResult(first, "\"bench\": \"lineScan\", \"pattern\": " + jsonString(pattern) + ", \"engine\": " + jsonString(matcher->engineName()) +
+                    ", \"lines\": " + std::to_string(lines) + ", \"hits\": " + std::to_string(hits) +
+                    ", \"mb_s\": " + std::to_string(static_cast<double>(text.size()) / MB / secs));
+    }
+
+    std::cout << "\n]\n";
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+#include "dfa_matcher.hpp"
+#include "config.hpp"
+#include "matcher.hpp"
+
+// Compares the lazy-DFA engine against std::regex on a synthetic corpus of
+// source-like lines.
+static std::vector<std::string> makeCorpus(std::size_t lines){
+    static const char* words[] = {"int", "return", "myFunction", "value", "std::string", "if", "for",
+                                  "while", "config", "TODO", "const", "auto", "{", "}", "(", ")", ";"};
+    std::mt19937 rng(1234);
+    std::vector<std::string> corpus;
+    corpus.reserve(lines);
+    for(std::size_t i = 0; i < lines; ++i){
+        std::string line;
+        std::size_t wordsInLine = rng() % 16;
+        for(std::size_t w = 0; w < wordsInLine; ++w){
+            line += words[rng() % (sizeof(words) / sizeof(words[0]))];
+            line += ' ';
+        }
+        corpus.push_back(std::move(line));
+    }
+    return corpus;
+}
+
+static double timeMatcher(const Matcher& matcher, const std::vector<std::string>& corpus, std::size_t& hits){
+    auto start = std::chrono::steady_clock::now();
+    hits = 0;
+    for(const auto &line : corpus){
+        if(matcher.search(line)) ++hits;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(){
+    const auto corpus = makeCorpus(200000);
+    std::size_t bytes = 0;
+    for(const auto &line : corpus) bytes += line.size() + 1;
+
+    const char* patterns[] = {"myFunction", "TODO|FIXME", "std::\\w+", "^\\s*return\\s+\\d+", "(a|b)*c[0-9]{2,4}"};
+
+    std::cout << "[\n";
+    bool first = true;
+    for(const char *pattern : patterns){
+        auto [dfa, err] = compileDfaMatcher(pattern, true);
+        if(err != RegexError::Ok) continue;
+        StdRegexMatcher fallback(std::regex(pattern, std::regex::ECMAScript | std::regex::icase));
+
+        std::size_t dfaHits = 0;
+        std::size_t stdHits = 0;
+        double dfaSecs = timeMatcher(*dfa, corpus, dfaHits);
+        double stdSecs = timeMatcher(fallback, corpus, stdHits);
+
+        if(!first) std::cout << ",\n";
+        first = false;
+        std::cout << "  {\"pattern\": \"";
+        for(const char *c = pattern; *c; ++c){
+            if(*c == '\\' || *c == '"') std::cout << '\\';
+            std::cout << *c;
+        }
+        std::cout << "\", \"hits\": " << dfaHits
+                  << ", \"hits_agree\": " << (dfaHits == stdHits ? "true" : "false")
+                  << ", \"lazy_dfa_mb_s\": " << (static_cast<double>(bytes) / MB / dfaSecs)
+                  << ", \"std_regex_mb_s\": " << (static_cast<double>(bytes) / MB / stdSecs)
+                  << ", \"speedup\": " << (stdSecs / dfaSecs) << "}";
+    }
+    std::cout << "\n]\n";
+    return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "config.hpp"
+#include "errors.hpp"
+
+// Appends lines to one file through a descriptor that stays open for the
+// whole session. Lines collect in a buffer that is written out once it
+// holds APPEND_BUFFER_SIZE bytes, or by a background flusher once its
+// oldest line has waited APPEND_FLUSH_INTERVAL. The sync policy decides
+// when fdatasync runs; with SyncPolicy::Always every line is written and
+// synced before append() returns.
+class AppendSession{
+public:
+    explicit AppendSession(SyncPolicy policy) : policy(policy) {}
+    ~AppendSession();
+
+    AppendSession(const AppendSession&) = delete;
+    AppendSession& operator=(const AppendSession&) = delete;
+
+    [[nodiscard]] FileError open(const std::string& filename);
+    // Queues `line` plus a newline. A failed background write is reported
+    // by the next call.
+    [[nodiscard]] FileError append(std::string_view line);
+    // Writes out what is left, syncs unless the policy is None, and closes
+    // the file.
+    [[nodiscard]] FileError close();
+
+private:
+    void runFlusher();
+    void flushLocked();
+
+    SyncPolicy policy;
+    std::string path;
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = -1;
+#else
+    std::FILE* file = nullptr;
+#endif
+    bool dirty = false;
+    FileError error = FileError::Ok;
+
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::string pending;
+    std::chrono::steady_clock::time_point firstPending;
+    bool stopping = false;
+    std::thread flusher;
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Monotonic allocator for data that lives as long as one command, such as
+// path strings. Allocation is a pointer bump inside a
+// block; nothing is freed on its own, and reset() releases everything at
+// once while keeping the first block for the next command. Not thread-safe;
+// each thread uses its own through threadArena().
+class Arena{
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    [[nodiscard]] void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t));
+
+    // Copies `text` into the arena with a terminating NUL, so the result
+    // can also be passed to C APIs through data().
+    [[nodiscard]] std::string_view copy(std::string_view text);
+    // `dir` + "/" + `name`, NUL-terminated, without doubling a trailing
+    // separator.
+    [[nodiscard]] std::string_view joinPath(std::string_view dir, std::string_view name);
+
+    void reset();
+    // Bytes handed out since the last reset.
+    [[nodiscard]] std::size_t used() const { return usedBytes; }
+
+private:
+    struct Block{
+        std::unique_ptr<char[]> data;
+        std::size_t size = 0;
+    };
+
+    void grow(std::size_t minBytes);
+
+    std::vector<Block> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    std::size_t usedBytes = 0;
+};
+
+// The calling thread's arena. Worker pools live for one command, so a
+// worker's arena is released when its pool shuts down. A long-lived thread
+// must reset() its own.
+[[nodiscard]] Arena& threadArena();
@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "bounded_queue.hpp"
+#include "errors.hpp"
+#include "file_reader.hpp"
+
+// One file handed out by AsyncFileReader. Files shorter than
+// ASYNC_READ_BUFFER_SIZE arrive with their contents and identity. Longer
+// ones arrive unread with `deferred` set, and the consumer reads them
+// itself with readWholeFile.
+struct AsyncReadFile{
+    std::string_view path;
+    std::unique_ptr<char[]> buffer;
+    std::size_t size = 0;
+    FileIdentity identity;
+    FileError error = FileError::Ok;
+    bool deferred = false;
+
+    [[nodiscard]] std::string_view view() const { return {buffer.get(), size}; }
+};
+
+// Reader stage built on io_uring, driven by raw syscalls. A background
+// thread keeps up to `queueDepth` opens and reads in flight. Finished files
+// go to consumers through a bounded queue, so a slow matching stage holds
+// the reader back. Each opened file is fstat'ed first: one too large for
+// the buffer is deferred without a read, and one `skip` (as in
+// readWholeFile) accepts is closed unread. Check ok() first: it is false where io_uring cannot be
+// set up (old kernel, seccomp, non-Linux), and callers then read the files
+// themselves.
+class AsyncFileReader{
+public:
+    AsyncFileReader(std::size_t queueDepth, std::size_t maxSize, bool (*skip)(const FileIdentity&) = nullptr);
+    ~AsyncFileReader();
+
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+    [[nodiscard]] bool ok() const { return ready; }
+
+    // Producer side: queue a path, then call finish() after the last one.
+    // The reader keeps only the view, so `path` must be NUL-terminated and
+    // outlive the reader.
+    void submit(std::string_view path);
+    void finish();
+
+    // Consumer side: blocks for the next file; false once all are done.
+    [[nodiscard]] bool next(AsyncReadFile& out);
+    // Hands a consumed file's buffer back for reuse.
+    void recycle(AsyncReadFile& file);
+
+private:
+    struct Ring;
+
+    void run();
+    [[nodiscard]] std::unique_ptr<char[]> takeBuffer();
+
+    std::unique_ptr<Ring> ring;
+    std::size_t depth;
+    std::size_t maxSize;
+    bool (*skip)(const FileIdentity&);
+    bool ready = false;
+
+    BoundedQueue<std::string_view> paths;
+    BoundedQueue<AsyncReadFile> results;
+
+    std::mutex bufferMtx;
+    std::vector<std::unique_ptr<char[]>> freeBuffers;
+
+    std::thread worker;
+};
+
+// True if this kernel lets the process create an io_uring that supports
+// every operation the reader uses.
+[[nodiscard]] bool asyncReadAvailable();
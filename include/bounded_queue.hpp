@@ -0,0 +1,68 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+// Blocking FIFO with a fixed capacity. push() waits while the queue is full
+// and pop() waits while it is empty; after close() pushes are dropped and
+// pop() returns false once the queue has drained.
+template <typename T>
+class BoundedQueue{
+public:
+    explicit BoundedQueue(std::size_t capacity) : capacity(capacity ? capacity : 1) {}
+
+    bool push(T item){
+        std::unique_lock<std::mutex> lock(mtx);
+        notFull.wait(lock, [this]{ return closed || items.size() < capacity; });
+        if(closed) return false;
+        items.push_back(std::move(item));
+        lock.unlock();
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool pop(T& out){
+        std::unique_lock<std::mutex> lock(mtx);
+        notEmpty.wait(lock, [this]{ return closed || !items.empty(); });
+        return takeLocked(out, lock);
+    }
+
+    // Like pop(), but returns false instead of waiting.
+    bool tryPop(T& out){
+        std::unique_lock<std::mutex> lock(mtx);
+        return takeLocked(out, lock);
+    }
+
+    // True once close() was called and every item has been taken.
+    bool drained(){
+        std::lock_guard<std::mutex> lock(mtx);
+        return closed && items.empty();
+    }
+
+    void close(){
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            closed = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+private:
+    bool takeLocked(T& out, std::unique_lock<std::mutex>& lock){
+        if(items.empty()) return false;
+        out = std::move(items.front());
+        items.pop_front();
+        lock.unlock();
+        notFull.notify_one();
+        return true;
+    }
+
+    std::mutex mtx;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<T> items;
+    std::size_t capacity;
+    bool closed = false;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "config.hpp"
+#include "errors.hpp"
+#include "matcher.hpp"
+
+// Outcome of a bulk `create` or `delete`: how many files succeeded and, for
+// every error that occurred, how many files hit it and the first of them.
+struct BulkSummary{
+    std::size_t done = 0;
+    std::size_t failed = 0;
+    std::map<FileError, std::pair<std::size_t, std::string>> errors;
+
+    void fail(FileError err, std::string_view path);
+    void merge(const BulkSummary& other);
+};
+
+// Expands one numeric range such as "log{1..500}.txt" or "{001..100}.csv"
+// into its names; a bound with leading zeros pads every number to its
+// width. A name without a range comes back alone.
+[[nodiscard]] std::pair<std::vector<std::string>, InputError> expandNameRange(std::string_view name);
+
+// Creates every name in parallel with openat(O_EXCL) relative to its
+// parent directory, opened once per run of names that share it.
+void createFiles(const std::vector<std::string>& names, std::size_t threads, BulkSummary& summary);
+
+// Deletes the files below `start` whose names match `matcher`, skipping
+// ignored directories unless `config.useIgnore` is off and `.git` always.
+// Each directory's matches are unlinked with unlinkat on one directory fd,
+// and directories are handled in parallel. A dry run prints the matches in
+// order instead.
+[[nodiscard]] RegexError deleteMatching(const Matcher& matcher, const BulkConfig& config, BulkSummary& summary,
+                                        const std::filesystem::path& start = std::filesystem::current_path());
+
+// Prints "[INFO] <verb> N of M files." and one error line per failure kind.
+void reportBulkSummary(const BulkSummary& summary, const char* verb);
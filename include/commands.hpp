@@ -1,4 +1,7 @@
 #pragma once
+#include <istream>
 #include "input_utils.hpp"
 
-void executeCommand(const Command& cmd, const std::string& input);
+// Runs one command line. Commands that read further lines, such as `add`,
+// read them from `in`, the stream the command line came from.
+void executeCommand(const Command& cmd, const std::string& input, std::istream& in);
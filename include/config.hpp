@@ -1,7 +1,11 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
+#include <chrono>
 #include <string>
+#include <string_view>
+#include <thread>
+#include "name_filter.hpp"
 
 constexpr std::uintmax_t KB = 1024;
 constexpr std::uintmax_t MB = 1024 * KB;
@@ -9,17 +13,104 @@ constexpr std::uintmax_t GB = MB * 1024;
 
 constexpr size_t MAX_INPUT_LENGTH = 250;
 constexpr size_t BINARY_CHECK_BUFFER_SIZE = 512;
+constexpr size_t MMAP_THRESHOLD = 256 * KB;
+constexpr size_t READ_BUFFER_SIZE = 256 * KB;
+constexpr size_t DIR_READ_BUFFER_SIZE = 64 * KB;
+constexpr size_t OUTPUT_BUFFER_SIZE = 64 * KB;
+constexpr size_t ASYNC_READ_BUFFER_SIZE = 64 * KB;
+constexpr size_t ASYNC_READ_DEPTH = 64;
+constexpr size_t ARENA_BLOCK_SIZE = 64 * KB;
+constexpr size_t MAX_BULK_CREATE = 1000000;
+constexpr size_t MAX_THREADS_PER_CORE = 4;
+constexpr size_t APPEND_BUFFER_SIZE = 1 * MB;
+constexpr std::chrono::milliseconds APPEND_FLUSH_INTERVAL{200};
 
-struct ParsedArg{
-    std::string command;
-    std::string value;
-    std::string unit;
-    bool hasValue = true;
+constexpr std::size_t LINE_INDEX_STRIDE = 4096;
+constexpr std::size_t MAX_CACHED_LINE_INDEXES = 64;
+constexpr std::size_t PATTERN_CACHE_CAPACITY = 64;
+constexpr std::size_t CONTENT_CACHE_CAPACITY = 64 * 1024;
+
+constexpr const char* INDEX_FILE_NAME = ".filecli-index";
+
+constexpr const char* HIGHLIGHT_START = "\x1b[1;31m";
+constexpr const char* HIGHLIGHT_END = "\x1b[0m";
+
+inline std::size_t defaultThreadCount(){
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : hw;
+}
+
+// Largest --threads accepted. Far more threads than cores gains nothing,
+// and past the system's limit std::thread throws.
+inline std::size_t maxThreadCount(){
+    return defaultThreadCount() * MAX_THREADS_PER_CORE;
+}
+
+// How `search` and `find` print results: the human layout, one JSON object
+// per line, or NUL-terminated fields.
+enum class OutputFormat{
+    Text,
+    JsonLines,
+    Null
 };
 
 struct SearchConfig{
-    std::uintmax_t maxFileSize = MB * 5;
+    std::uintmax_t maxFileSize = GB;
     std::size_t maxGlobalMatches = 500;
     std::size_t maxMatchesPerFile = 500;
     int maxDepth = -1;
+    std::size_t threads = defaultThreadCount();
+    bool useIndex = false;
+    bool showStats = false;
+    bool asyncRead = true;
+    bool useIgnore = true;
+    NameFilter names;
+    OutputFormat format = OutputFormat::Text;
+    std::size_t beforeContext = 0;
+    std::size_t afterContext = 0;
+    bool highlight = false;
+};
+
+// Line range for `read`. `count` 0 means to the end of the file; a non-zero
+// `tail` selects the last `tail` lines instead of starting at `fromLine`.
+struct ReadConfig{
+    std::uint64_t fromLine = 1;
+    std::uint64_t count = 0;
+    std::uint64_t tail = 0;
+};
+
+struct FindConfig{
+    std::size_t threads = defaultThreadCount();
+    bool sorted = false;
+    int maxDepth = -1;
+    bool useIgnore = true;
+    NameFilter names;
+    OutputFormat format = OutputFormat::Text;
 };
+
+// Targets of a bulk `delete`: files below the starting directory whose
+// names match `pattern`, outside ignored and `.git` directories. With
+// `dryRun` they are listed instead of deleted. Bulk `create` only uses
+// `threads`.
+struct BulkConfig{
+    std::string_view pattern;
+    int maxDepth = -1;
+    std::size_t threads = defaultThreadCount();
+    bool useIgnore = true;
+    bool dryRun = false;
+};
+
+// When `add` calls fdatasync: never, after each batch it writes out, or
+// after every line.
+enum class SyncPolicy{
+    None,
+    Batch,
+    Always
+};
+
+struct AppendConfig{
+    SyncPolicy sync = SyncPolicy::Batch;
+};
+
+// `list` takes no flags; its table rejects any that are given.
+struct ListConfig{};
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include "file_reader.hpp"
+
+enum class ContentKind : std::uint8_t{
+    Text,
+    Utf16LE,
+    Utf16BE,
+    Binary,
+};
+
+// Classifies a file from its first BINARY_CHECK_BUFFER_SIZE bytes. A UTF-16
+// byte order mark wins first. Then known magic numbers (ELF, PNG, gzip, zip
+// and the like) mark binaries. Otherwise a NUL byte, or more than one byte
+// in eight being a control character or part of invalid UTF-8, means
+// binary. The NUL and control scan runs 16 bytes at a time with SSE2.
+[[nodiscard]] ContentKind classifyContent(std::string_view content);
+
+// True for file names whose extension always means a binary format
+// (images, archives, object code, media, fonts). Such files are skipped
+// without being opened.
+[[nodiscard]] bool isKnownBinaryName(std::string_view name);
+
+// The text to search in `content`: the content itself for Text, or the
+// UTF-16 content converted to UTF-8 in a per-thread buffer. That view stays
+// valid until the thread's next call.
+[[nodiscard]] std::string_view searchableText(std::string_view content, ContentKind kind);
+
+// Number of bytes that `utf8`, a stretch of searchableText's output for a
+// UTF-16 file, took up in that file. Maps offsets in the transcoded text
+// back to the file.
+[[nodiscard]] std::size_t utf16ByteLength(std::string_view utf8);
+
+// Classifications remembered across searches, keyed by device and inode and
+// dropped when the file's size or mtime changes.
+[[nodiscard]] bool cachedContentKind(const FileIdentity& identity, ContentKind& out);
+void rememberContentKind(const FileIdentity& identity, ContentKind kind);
+// Suits readWholeFile's `skip` hook: true for files last seen as binary.
+[[nodiscard]] bool isCachedBinary(const FileIdentity& identity);
@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+#include <utility>
+#include "errors.hpp"
+#include "matcher.hpp"
+
+// Thompson NFA compiled on demand into a DFA, one cache per thread. Runs in
+// linear time per line. Returns RegexError::UnsupportedSyntax for constructs
+// it does not implement (backreferences, lookaround, word boundaries, ...),
+// in which case callers fall back to std::regex.
+[[nodiscard]] std::pair<MatcherPtr, RegexError> compileDfaMatcher(const std::string& pattern, bool icase);
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "arena.hpp"
+#include "errors.hpp"
+
+enum class EntryType : std::uint8_t{
+    File,
+    Directory,
+    Symlink,
+    Other,
+};
+
+enum class WalkAction{
+    Continue,
+    SkipChildren,
+    Stop,
+};
+
+// One entry handed to a walkTree visitor. Only valid during the call; the
+// full path string is built on request.
+class WalkEntry{
+public:
+    [[nodiscard]] std::string_view name() const { return entryName; }
+    [[nodiscard]] EntryType type() const { return entryType; }
+    [[nodiscard]] int depth() const { return entryDepth; }
+    [[nodiscard]] std::string path() const;
+    // Same path, built NUL-terminated inside `arena`.
+    [[nodiscard]] std::string_view path(Arena& arena) const;
+    // True for regular files, following symlinks. Only symlinks cost a stat.
+    [[nodiscard]] bool isRegularFile() const;
+
+private:
+    friend FileError walkTree(const std::filesystem::path& root, const std::function<WalkAction(const WalkEntry&)>& visit);
+
+    int dirFd = -1;
+    const std::string* dirPath = nullptr;
+    std::string_view entryName;
+    EntryType entryType = EntryType::Other;
+    int entryDepth = 0;
+};
+
+// Depth-first walk below `root` in directory order; a directory's contents
+// follow it right away, as with recursive_directory_iterator. Symlinked
+// directories are not followed and unreadable directories are skipped.
+[[nodiscard]] FileError walkTree(const std::filesystem::path& root, const std::function<WalkAction(const WalkEntry&)>& visit);
+
+// Calls `emit` for every entry of the directory `path` except "." and "..".
+[[nodiscard]] FileError listDirectory(const std::string& path, const std::function<void(std::string_view, EntryType)>& emit);
+
+// `dir` + "/" + `name`, without doubling a trailing separator.
+[[nodiscard]] std::string joinPath(const std::string& dir, std::string_view name);
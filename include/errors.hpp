@@ -15,6 +15,9 @@ enum class FileError{
     DiskFull,
     PathNotFound,
     NotADirectory,
+    NotSupported,
+    FileTooLarge,
+    Skipped,
     UnknownError,
 };
 
@@ -35,6 +38,8 @@ enum class RegexError{
     NotInFiles,
     NoFileFound,
     InternalRegexError,
+    UnsupportedSyntax,
+    IndexUnavailable,
     UnknownError,
 };
 
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "errors.hpp"
+
+// Identity of a file as seen by fstat, enough to notice that it changed.
+// All zero where the platform gives no inode.
+struct FileIdentity{
+    std::uint64_t device = 0;
+    std::uint64_t inode = 0;
+    std::int64_t mtime = 0;
+    std::uint64_t size = 0;
+};
+
+// Read-only view of a whole file. Files of at least MMAP_THRESHOLD bytes are
+// memory-mapped; smaller ones are pread into a buffer owned by the calling
+// thread, so that view is only valid until the thread's next readWholeFile.
+// Files larger than `maxSize` are not read and yield FileError::FileTooLarge.
+class FileBuffer{
+public:
+    FileBuffer() = default;
+    ~FileBuffer();
+
+    FileBuffer(FileBuffer&& other) noexcept;
+    FileBuffer& operator=(FileBuffer&& other) noexcept;
+    FileBuffer(const FileBuffer&) = delete;
+    FileBuffer& operator=(const FileBuffer&) = delete;
+
+    [[nodiscard]] std::string_view view() const { return {data, size}; }
+    [[nodiscard]] bool isMapped() const { return mapped; }
+    [[nodiscard]] const FileIdentity& identity() const { return fileIdentity; }
+
+private:
+    friend std::pair<FileBuffer, FileError> readWholeFile(const char* path, std::size_t maxSize, bool (*skip)(const FileIdentity&));
+
+    void release();
+
+    const char* data = nullptr;
+    std::size_t size = 0;
+    bool mapped = false;
+    FileIdentity fileIdentity;
+};
+
+// Fills `out` from fstat on an open file; false if fstat fails.
+[[nodiscard]] bool statIdentity(int fd, FileIdentity& out);
+
+// `skip`, when given, sees the file's identity before any data is read; if
+// it returns true the file is closed unread with FileError::Skipped.
+[[nodiscard]] std::pair<FileBuffer, FileError> readWholeFile(const char* path, std::size_t maxSize = SIZE_MAX, bool (*skip)(const FileIdentity&) = nullptr);
@@ -1,19 +1,107 @@
 #pragma once
 #include "errors.hpp"
 #include "config.hpp"
-#include <vector>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
+
+std::vector<std::string_view> tokenize(std::string_view sv);
 
-std::string_view extractQuery(std::string_view sv);
+[[nodiscard]] FlagError parseNumber(std::string_view num, uintmax_t& out);
 
-std::string_view skipWords(std::string_view sv);
+// How a flag takes its value.
+enum class FlagValue{
+    // A switch such as --stats; giving it a value is an error.
+    None,
+    // A plain number such as --max-depth=3.
+    Number,
+    // A number with a KB, MB or GB unit such as --max-file-size=10MB, in bytes.
+    Size,
+    // Everything after '=' taken whole, such as --glob=*.cpp.
+    Text,
+};
 
-std::vector<std::string_view> tokenize(std::string_view sv);
+// One flag as handed to the field it sets: the name it was given as, the
+// text after '=', and for Number and Size flags the checked value. The
+// views point into the command line.
+struct FlagArg{
+    std::string_view name;
+    std::string_view text;
+    std::uintmax_t number = 0;
+};
+
+// One row of a command's flag table.
+template<typename Config>
+struct FlagSpec{
+    std::string_view name;
+    std::string_view alias;
+    FlagValue value;
+    // Smallest Number value accepted.
+    std::uintmax_t min;
+    FlagError (*store)(const FlagArg&, Config&);
+};
+
+// The flags one command accepts.
+template<typename Config>
+class FlagTable{
+public:
+    constexpr FlagTable() = default;
+    template<std::size_t N>
+    constexpr FlagTable(const FlagSpec<Config> (&specs)[N]) : first(specs), count(N) {}
+
+    [[nodiscard]] constexpr const FlagSpec<Config>* find(std::string_view name) const{
+        for(std::size_t i = 0; i < count; ++i){
+            if(first[i].name == name || (!first[i].alias.empty() && first[i].alias == name)) return &first[i];
+        }
+        return nullptr;
+    }
+
+private:
+    const FlagSpec<Config> *first = nullptr;
+    std::size_t count = 0;
+};
+
+extern const FlagTable<SearchConfig> SEARCH_FLAGS;
+extern const FlagTable<FindConfig> FIND_FLAGS;
+extern const FlagTable<ReadConfig> READ_FLAGS;
+extern const FlagTable<AppendConfig> ADD_FLAGS;
+extern const FlagTable<BulkConfig> CREATE_FLAGS;
+extern const FlagTable<BulkConfig> DELETE_FLAGS;
+extern const FlagTable<ListConfig> LIST_FLAGS;
+
+// grep's "-A N", "-B N" and "-C N" (or "-C2") at the end of a search query
+// are cut off `query` and returned as "--A=N" and so on, in their original
+// order, so they set context instead of being searched for. A query made
+// of nothing else is left whole.
+[[nodiscard]] std::string takeContextShorthand(std::string_view& query);
+
+// Splits the next "--name[=value]" off `params`, skipping spaces. Leaves
+// `name` empty once `params` is used up.
+[[nodiscard]] FlagError nextFlag(std::string_view& params, std::string_view& name, std::string_view& text, bool& hasValue);
 
-bool isFlag(const std::string_view& flag);
+// Checks a flag's value against its kind and fills in `arg.number`.
+[[nodiscard]] FlagError readFlagValue(FlagValue value, std::uintmax_t min, bool hasValue, FlagArg& arg);
 
-std::pair<std::vector<ParsedArg>, FlagError> splitFlag(const std::vector<std::string_view>& flags);
+// Applies every flag in `params` to `config` through `table`, stopping at
+// the first error. The parse itself copies and allocates nothing; only a
+// flag whose value is stored in an owning field allocates, such as the
+// patterns --type, --glob and --exclude add to a NameFilter.
+template<typename Config>
+[[nodiscard]] FlagError parseFlags(std::string_view params, const FlagTable<Config>& table, Config& config){
+    while(true){
+        FlagArg arg;
+        bool hasValue = false;
+        FlagError err = nextFlag(params, arg.name, arg.text, hasValue);
+        if(err != FlagError::Ok) return err;
+        if(arg.name.empty()) return FlagError::Ok;
 
-[[nodiscard]] FlagError parseNumber(const std::string& num, uintmax_t& out);
-[[nodiscard]] FlagError parseSize(const ParsedArg& arg, uintmax_t& out);
-[[nodiscard]] FlagError applyFlag(const ParsedArg& arg, SearchConfig& config);
+        const FlagSpec<Config> *spec = table.find(arg.name);
+        if(!spec) return FlagError::UnknownFlag;
+        err = readFlagValue(spec->value, spec->min, hasValue, arg);
+        if(err != FlagError::Ok) return err;
+        err = spec->store(arg, config);
+        if(err != FlagError::Ok) return err;
+    }
+}
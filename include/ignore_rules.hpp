@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class IgnoreVerdict{
+    None,
+    Ignore,
+    Include,
+};
+
+// Compiled rules of one directory's .gitignore and .ignore, in file order
+// (.ignore last, so it wins). Rules that name a file or directory exactly
+// go into hash maps, as do "*.ext" rules keyed by their suffix; the rest
+// are globs, tried from the last rule back. As in git the last matching
+// rule decides.
+class IgnoreRules{
+public:
+    // Adds one line of an ignore file; blank lines and comments are skipped.
+    void add(std::string_view line);
+    [[nodiscard]] bool empty() const { return rules.empty(); }
+
+    // Verdict for an entry called `name` whose path relative to the
+    // directory holding these rules is `rel`.
+    [[nodiscard]] IgnoreVerdict match(std::string_view rel, std::string_view name, bool isDir) const;
+
+private:
+    struct Rule{
+        std::string pattern;
+        bool negated = false;
+        bool dirOnly = false;
+        // Matched against the entry name instead of its relative path.
+        bool basename = false;
+    };
+
+    using Lookup = std::unordered_map<std::string, std::uint32_t>;
+
+    static void lookup(const Lookup& table, std::string_view key, std::int64_t& best);
+
+    std::vector<Rule> rules;
+    Lookup names, dirNames;
+    Lookup paths, dirPaths;
+    Lookup suffixes, dirSuffixes;
+    std::vector<std::uint32_t> globs;
+};
+
+// Ignore rules in effect inside one directory: its own files and those of
+// every ancestor, back to the repository root. Scopes are immutable, so
+// the tasks of a parallel walk can share them.
+class IgnoreScope : public std::enable_shared_from_this<IgnoreScope>{
+public:
+    // True if `name`, a direct child of this directory, is ignored. `.git`
+    // directories always are.
+    [[nodiscard]] bool ignored(std::string_view name, bool isDir) const;
+
+    // Scope of the subdirectory `name`, whose full path is `path`. Its
+    // ignore files are read only when `mayHaveRules` is set.
+    [[nodiscard]] std::shared_ptr<const IgnoreScope> child(std::string_view name, std::string_view path, bool mayHaveRules = true) const;
+
+private:
+    friend std::shared_ptr<const IgnoreScope> ignoreScopeFor(const std::filesystem::path& root);
+
+    struct Frame{
+        std::shared_ptr<const IgnoreRules> rules;
+        // Length of the holding directory's prefix in `relDir`.
+        std::size_t base = 0;
+    };
+
+    std::shared_ptr<const std::vector<Frame>> frames;
+    // This directory relative to the outermost frame's, with a trailing '/'.
+    std::string relDir;
+};
+
+// Root scope for a walk starting at `root`. Parent directories up to the
+// enclosing repository (the nearest one holding `.git`) contribute their
+// ignore files as well.
+[[nodiscard]] std::shared_ptr<const IgnoreScope> ignoreScopeFor(const std::filesystem::path& root);
+
+// Checks single paths below `root` that did not come from a walk, such as
+// index candidates. Scopes of the directories seen are kept, so a batch of
+// paths reads each ignore file once.
+class IgnorePathFilter{
+public:
+    explicit IgnorePathFilter(const std::filesystem::path& root);
+
+    // True if `path`, or a directory above it, is ignored. Paths outside
+    // the root never are.
+    [[nodiscard]] bool ignored(std::string_view path, bool isDir = false);
+
+private:
+    // Null when the directory itself is ignored.
+    [[nodiscard]] const IgnoreScope* scopeOf(std::string_view relDir);
+
+    std::string root;
+    std::shared_ptr<const IgnoreScope> rootScope;
+    std::unordered_map<std::string, std::shared_ptr<const IgnoreScope>> dirs;
+};
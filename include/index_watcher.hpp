@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "config.hpp"
+#include "errors.hpp"
+
+// Keeps an in-memory trigram index of one tree current from inotify events
+// on a background thread, saving it back to disk when changes settle.
+[[nodiscard]] FileError startWatching(const std::filesystem::path& root);
+[[nodiscard]] FileError stopWatching();
+[[nodiscard]] bool watchedRoot(std::filesystem::path& root);
+
+// Applied immediately by the tool's own file operations; ignored when the
+// path is outside the watched tree.
+void noteFileChanged(const std::filesystem::path& path);
+void noteFileRemoved(const std::filesystem::path& path);
+
+// Answer from the live index when `start` lies inside the watched tree;
+// returns false otherwise so the caller falls back to a disk walk. Queued
+// events are applied first, so candidates need no stat checks.
+[[nodiscard]] bool liveIndexCandidates(const std::filesystem::path& start, const std::vector<std::uint32_t>& trigrams, const SearchConfig& config, std::vector<std::filesystem::path>& out);
+
+// True when `path` is a directory the watch covers. Queued events are
+// applied first, which drops the tree snapshots they touched, so a cached
+// snapshot of `path` can be used without its mtime check.
+[[nodiscard]] bool watchCovers(const std::filesystem::path& path);
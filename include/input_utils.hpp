@@ -1,5 +1,8 @@
 #pragma once
+#include <istream>
 #include <string>
+#include <string_view>
+#include "config.hpp"
 #include "errors.hpp"
 
 enum class Command{
@@ -13,12 +16,17 @@ enum class Command{
     Search,
     Delete,
     List,
+    Index,
+    Watch,
+    Cache,
     InvalidCommand,
 };
 
 [[nodiscard]] InputError parseInput(const std::string& input);
-[[nodiscard]] std::pair<std::string, InputError> parseCommand(const std::string& input);
-void handleEditCommand(const std::string& filename);
-Command matchCommand(const std::string& input);
+[[nodiscard]] std::pair<std::string_view, InputError> parseCommand(std::string_view input);
+// Appends the lines read from `in` to `filename` until "!exit" or the end
+// of `in`.
+void handleEditCommand(const std::string& filename, const AppendConfig& config, std::istream& in);
+Command matchCommand(std::string_view input);
 void showCommands();
 void showFlagDetails();
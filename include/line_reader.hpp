@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+#include "config.hpp"
+#include "errors.hpp"
+
+// Prints the lines of `filename` chosen by `config` as "N: text" through the
+// output sink. The file is streamed from a mapped or reused buffer, so
+// memory use does not grow with its size. Line positions come from a sparse
+// offset index that is cached per file until its inode, size or mtime
+// changes, so later range and tail reads seek instead of rescanning.
+[[nodiscard]] FileError streamFileLines(const std::string& filename, const ReadConfig& config);
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ASCII case-insensitive substring search. The kernel (AVX2, SSE2 or
+// scalar) is picked once at runtime from the CPU's features.
+class LiteralFinder{
+public:
+    LiteralFinder() = default;
+    explicit LiteralFinder(std::string needle);
+
+    [[nodiscard]] std::size_t find(std::string_view haystack, std::size_t from = 0) const;
+    [[nodiscard]] const std::string& needle() const { return lowered; }
+    [[nodiscard]] bool empty() const { return lowered.empty(); }
+
+private:
+    std::string lowered;
+    std::size_t lastIndex = 0;
+};
+
+[[nodiscard]] const char* literalKernelName();
+
+// Case-folded trigram code, as stored in the trigram index.
+[[nodiscard]] inline std::uint32_t packTrigram(unsigned char a, unsigned char b, unsigned char c){
+    auto fold = [](unsigned char byte) -> std::uint32_t { return (byte >= 'A' && byte <= 'Z') ? (byte | 0x20) : byte; };
+    return (fold(a) << 16) | (fold(b) << 8) | fold(c);
+}
+
+// Sorted, distinct trigrams of every string in `literals`.
+[[nodiscard]] std::vector<std::uint32_t> literalTrigrams(const std::vector<std::string>& literals);
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "literal_scan.hpp"
+
+struct MatchSpan{
+    std::size_t begin = 0;
+    std::size_t end = 0;
+};
+
+// Literal facts derived from the pattern. `required` lists lowercase
+// substrings every match contains, `trigrams` holds their index trigrams,
+// `finder` locates the longest of them and `pure` means the pattern is
+// exactly that literal.
+struct LiteralInfo{
+    std::vector<std::string> required;
+    std::vector<std::uint32_t> trigrams;
+    LiteralFinder finder;
+    bool pure = false;
+};
+
+// Compiled search pattern. Implementations must be safe to share between
+// scanner threads. find() reports the leftmost match that starts at or after
+// `from`; the text before `from` still counts for `^`.
+class Matcher{
+public:
+    virtual ~Matcher() = default;
+
+    [[nodiscard]] virtual bool search(std::string_view text) const = 0;
+    [[nodiscard]] virtual bool find(std::string_view text, std::size_t from, MatchSpan& span) const = 0;
+    [[nodiscard]] virtual const char* engineName() const = 0;
+
+    [[nodiscard]] const LiteralInfo& literalInfo() const { return literals; }
+    void setLiteralInfo(LiteralInfo info){
+        info.trigrams = literalTrigrams(info.required);
+        literals = std::move(info);
+    }
+
+private:
+    LiteralInfo literals;
+};
+
+using MatcherPtr = std::shared_ptr<const Matcher>;
+
+class StdRegexMatcher : public Matcher{
+public:
+    explicit StdRegexMatcher(std::regex re) : re(std::move(re)) {}
+
+    [[nodiscard]] bool search(std::string_view text) const override;
+    [[nodiscard]] bool find(std::string_view text, std::size_t from, MatchSpan& span) const override;
+    [[nodiscard]] const char* engineName() const override { return "std::regex"; }
+
+private:
+    std::regex re;
+};
+
+// Fast path for patterns that are a plain string, e.g. `TODO`.
+class LiteralMatcher : public Matcher{
+public:
+    explicit LiteralMatcher(std::string literal);
+
+    [[nodiscard]] bool search(std::string_view text) const override;
+    [[nodiscard]] bool find(std::string_view text, std::size_t from, MatchSpan& span) const override;
+    [[nodiscard]] const char* engineName() const override { return "literal"; }
+};
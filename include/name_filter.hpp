@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "errors.hpp"
+
+// gitignore-style glob: '*' and '?' stop at '/', "**" crosses it, "**/" may
+// also match nothing, and "[...]" is a character class.
+[[nodiscard]] bool globMatch(std::string_view pattern, std::string_view text);
+
+// Set of short strings looked up through a perfect hash: the seed and the
+// power-of-two table size are chosen when the set changes so that no two
+// members share a slot, and a lookup is one hash and one compare.
+class PerfectHashSet{
+public:
+    void insert(std::string_view key);
+    [[nodiscard]] bool contains(std::string_view key) const;
+    [[nodiscard]] bool empty() const { return keys.empty(); }
+
+private:
+    void rebuild();
+
+    std::vector<std::string> keys;
+    std::vector<std::string> slots;
+    std::uint32_t seed = 0;
+    std::uint32_t mask = 0;
+};
+
+// File name filters from --type, --glob and --exclude. Each pattern is
+// sorted into the cheapest test that can decide it: "*.ext" goes into a
+// perfect hash of extensions, a literal name into a perfect hash of names,
+// "*suffix" into a suffix check specialized for the suffix length, and
+// only the rest is matched as a glob.
+class NameFilter{
+public:
+    // Adds every type of a comma-separated list such as "cpp,py".
+    [[nodiscard]] FlagError addTypes(std::string_view list);
+    void addGlob(std::string_view pattern, bool exclude);
+
+    [[nodiscard]] bool empty() const { return include.empty() && exclude.empty(); }
+    // A file passes if it matches an include pattern (or there are none)
+    // and no exclude pattern.
+    [[nodiscard]] bool acceptsFile(std::string_view name) const { return (include.empty() || include.matches(name)) && !exclude.matches(name); }
+    // Directories are only held to the exclude patterns.
+    [[nodiscard]] bool acceptsDirectory(std::string_view name) const { return !exclude.matches(name); }
+    // For a file that did not come from a walk: `rel` is its '/'-separated
+    // path below the walk's root, and every directory on it must pass too.
+    [[nodiscard]] bool acceptsPath(std::string_view rel) const;
+
+private:
+    using SuffixTest = bool (*)(std::string_view, const char*, std::size_t);
+
+    struct Suffix{
+        std::string text;
+        SuffixTest test;
+    };
+
+    struct Glob{
+        std::string pattern;
+        // Length of the literal text after the last wildcard.
+        std::size_t tail;
+    };
+
+    struct PatternSet{
+        PerfectHashSet extensions;
+        PerfectHashSet names;
+        std::vector<Suffix> suffixes;
+        std::vector<Glob> globs;
+
+        void add(std::string_view pattern);
+        [[nodiscard]] bool matches(std::string_view name) const;
+        [[nodiscard]] bool empty() const { return extensions.empty() && names.empty() && suffixes.empty() && globs.empty(); }
+    };
+
+    PatternSet include;
+    PatternSet exclude;
+};
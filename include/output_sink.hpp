@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Formatting buffer for result text. Each thread reuses its own through
+// threadOutputBuffer(), so formatting takes no lock and no fresh allocation.
+class OutputBuffer{
+public:
+    OutputBuffer& operator<<(std::string_view text){
+        data.append(text.data(), text.size());
+        return *this;
+    }
+    OutputBuffer& operator<<(char c){
+        data.push_back(c);
+        return *this;
+    }
+    OutputBuffer& appendNumber(std::uint64_t value);
+
+    [[nodiscard]] std::string_view view() const { return data; }
+    [[nodiscard]] std::size_t size() const { return data.size(); }
+    [[nodiscard]] bool empty() const { return data.empty(); }
+    void clear() { data.clear(); }
+
+private:
+    std::string data;
+};
+
+[[nodiscard]] OutputBuffer& threadOutputBuffer();
+
+// Hands `buffer` to the shared stdout sink in one piece and clears it. The
+// sink writes with write(2): per call when stdout is a terminal, in
+// OUTPUT_BUFFER_SIZE blocks otherwise.
+void writeOutput(OutputBuffer& buffer);
+void writeOutput(std::string_view text);
+// Writes out anything still pending. Call before printing through std::cout.
+void flushOutput();
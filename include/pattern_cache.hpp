@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "matcher.hpp"
+
+struct PatternCacheStats{
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t size = 0;
+    std::size_t capacity = 0;
+};
+
+// Least-recently-used cache of compiled matchers keyed by pattern text and
+// compile options. A matcher carries its literal and trigram analysis, so a
+// hit needs no compile work at all. Lookups take a lock and hand every
+// caller the same shared instance. A capacity of 0 turns caching off.
+class PatternCache{
+public:
+    explicit PatternCache(std::size_t capacity);
+
+    [[nodiscard]] MatcherPtr find(const std::string& pattern, bool icase);
+    // Returns the cached matcher, which is the one already stored if another
+    // thread inserted the same key first.
+    [[nodiscard]] MatcherPtr insert(const std::string& pattern, bool icase, MatcherPtr matcher);
+    void setCapacity(std::size_t capacity);
+    void clear();
+    [[nodiscard]] PatternCacheStats stats() const;
+
+private:
+    using Entry = std::pair<std::string, MatcherPtr>;
+
+    void evictLocked();
+
+    mutable std::mutex mtx;
+    std::list<Entry> entries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> lookup;
+    std::size_t capacity;
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+};
+
+// Cache used by compileRegex.
+[[nodiscard]] PatternCache& patternCache();
+void printPatternCacheStats();
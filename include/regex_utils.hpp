@@ -1,9 +1,18 @@
 #pragma once
-#include <regex>
 #include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
 #include "errors.hpp"
 #include "config.hpp"
+#include "matcher.hpp"
 
-[[nodiscard]] std::pair<std::regex, RegexError> compileRegex(const std::string& pattern);
-[[nodiscard]] std::pair<std::vector<std::string>, RegexError> findFilesByName(const std::regex& re, const std::filesystem::path& start = std::filesystem::current_path());
-[[nodiscard]] RegexError findInFile(const std::string& pattern, const std::regex& re, SearchConfig& config, const std::filesystem::path& start = std::filesystem::current_path());
+[[nodiscard]] std::pair<MatcherPtr, RegexError> compileRegex(const std::string& pattern);
+// Paths of files under `start` whose name matches `matcher`, handed to `emit`
+// in batches as the worker threads find them. The views are only valid
+// during the call. Batches may arrive on several
+// threads at once and in any order. With config.sorted every path arrives in
+// a single batch in path order instead.
+[[nodiscard]] RegexError findFilesByName(const Matcher& matcher, const FindConfig& config, const std::function<void(std::vector<std::string_view>&)>& emit,
+                                         const std::filesystem::path& start = std::filesystem::current_path());
+[[nodiscard]] RegexError findInFile(const std::string& pattern, const Matcher& matcher, SearchConfig& config, const std::filesystem::path& start = std::filesystem::current_path());
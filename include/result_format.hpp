@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include "config.hpp"
+#include "matcher.hpp"
+#include "output_sink.hpp"
+
+// Machine-readable result records, written straight into an OutputBuffer.
+// They take no allocations of their own beyond the buffer's growth.
+//
+// jsonl: one object per line,
+//   {"path":"src/a.cpp","line":12,"offset":345,"spans":[[4,8]],"text":"..."}
+// where `offset` is the byte offset of the line in the file and each span is
+// a [begin, end) byte range of a match within the line's bytes. These are
+// the bytes of `text` unless the line holds invalid UTF-8, which `text`
+// shows as U+FFFD. For a UTF-16 file `offset` is still the line's position
+// in the file, while spans index the line's UTF-8 form in `text`.
+// null: the same fields in that order, each terminated by '\0', with spans
+// written as "4-8,10-12". `find` prints only the path.
+
+// Calls `emit` for each non-overlapping match in `line`, left to right.
+// `first`, when given, is the leftmost match, already found by the scan.
+template <typename Emit>
+void forEachMatchSpan(std::string_view line, const Matcher& matcher, const MatchSpan* first, Emit emit){
+    MatchSpan span;
+    if(first) span = *first;
+    else if(!matcher.find(line, 0, span)) return;
+    while(true){
+        emit(span);
+        // An empty match would be found again at the same place.
+        std::size_t from = span.end > span.begin ? span.end : span.end + 1;
+        if(from > line.size() || !matcher.find(line, from, span)) return;
+    }
+}
+
+// `text` is copied byte for byte; quotes, backslashes and control bytes are
+// escaped, and each byte that is not part of well-formed UTF-8 is written
+// as \ufffd so the record stays valid JSON.
+void appendJsonString(OutputBuffer& out, std::string_view text);
+
+// One matching line. The spans come from running `matcher` over `line`,
+// starting after `first` when the caller already has it.
+void appendMatchRecord(OutputBuffer& out, OutputFormat format, std::string_view path, std::uint64_t lineNumber,
+                       std::uint64_t offset, std::string_view line, const Matcher& matcher, const MatchSpan* first = nullptr);
+
+// One `find` result.
+void appendPathRecord(OutputBuffer& out, OutputFormat format, std::string_view path);
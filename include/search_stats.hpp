@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+enum class StatCounter : std::size_t{
+    FilesVisited,
+    SkippedSize,
+    SkippedBinary,
+    SkippedPermission,
+    SkippedUnreadable,
+    SkippedIgnored,
+    SkippedFiltered,
+    Transcoded,
+    BytesRead,
+    LinesScanned,
+    RegexCalls,
+    Matches,
+    Count,
+};
+
+enum class StatPhase : std::size_t{
+    Walk,
+    Read,
+    BinaryCheck,
+    Match,
+    Output,
+    Count,
+};
+
+// Counters and per-phase times for one search, shared by the walker and all
+// scanner threads. Phase times are summed over threads.
+class SearchStats{
+public:
+    void add(StatCounter counter, std::uint64_t amount = 1){
+        counters[static_cast<std::size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+    }
+    void addTime(StatPhase phase, std::uint64_t wallNs, std::uint64_t cpuNs){
+        wallTimes[static_cast<std::size_t>(phase)].fetch_add(wallNs, std::memory_order_relaxed);
+        cpuTimes[static_cast<std::size_t>(phase)].fetch_add(cpuNs, std::memory_order_relaxed);
+    }
+
+    // Prints the summary; `totalWallNs` is the elapsed time of the whole search.
+    void print(std::uint64_t totalWallNs) const;
+
+private:
+    std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(StatCounter::Count)> counters{};
+    std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(StatPhase::Count)> wallTimes{};
+    std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(StatPhase::Count)> cpuTimes{};
+};
+
+// Calling thread's CPU time in nanoseconds.
+[[nodiscard]] std::uint64_t threadCpuNs();
+
+// Adds the wall and CPU time of a scope to `stats`. With a null `stats`
+// (the default, --stats off) it reads no clocks at all.
+class ScopedTimer{
+public:
+    ScopedTimer(SearchStats* stats, StatPhase phase) : stats(stats), phase(phase){
+        if(stats){
+            wallStart = std::chrono::steady_clock::now();
+            cpuStart = threadCpuNs();
+        }
+    }
+    ~ScopedTimer() { stop(); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    void stop(){
+        if(!stats) return;
+        auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wallStart);
+        stats->addTime(phase, static_cast<std::uint64_t>(wall.count()), threadCpuNs() - cpuStart);
+        stats = nullptr;
+    }
+
+private:
+    SearchStats* stats;
+    StatPhase phase;
+    std::chrono::steady_clock::time_point wallStart;
+    std::uint64_t cpuStart = 0;
+};
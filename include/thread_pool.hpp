@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool where every worker owns a task deque. Workers pop from the
+// back of their own deque and steal from the front of the others when idle.
+class WorkStealingPool{
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(std::size_t threadCount);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Task task);
+    void wait();
+    std::size_t size() const { return workers.size(); }
+
+private:
+    struct Worker{
+        std::deque<Task> tasks;
+        std::mutex mtx;
+    };
+
+    bool popLocal(std::size_t self, Task& out);
+    bool steal(std::size_t self, Task& out);
+    void run(std::size_t self);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> nextQueue{0};
+    std::atomic<std::size_t> pending{0};
+    std::atomic<bool> stopping{false};
+
+    std::mutex sleepMtx;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+};
+
+// Splits [0, count) into chunks of at least `grain` items, runs
+// fn(begin, end) for each on `pool` and waits for all of them. Must be
+// called from outside the pool.
+void parallelFor(WorkStealingPool& pool, std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& fn);
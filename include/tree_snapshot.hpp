@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "arena.hpp"
+#include "dir_walker.hpp"
+#include "errors.hpp"
+#include "thread_pool.hpp"
+
+// Flat, struct-of-arrays copy of a directory tree. Entry 0 is the root; the
+// children of every directory are stored contiguously, names are interned
+// into one character pool and each entry points at its parent by index.
+class TreeSnapshot{
+public:
+    static constexpr std::uint32_t NO_PARENT = UINT32_MAX;
+
+    [[nodiscard]] std::size_t size() const { return types.size(); }
+    [[nodiscard]] EntryType type(std::uint32_t entry) const { return types[entry]; }
+    [[nodiscard]] std::uint32_t parent(std::uint32_t entry) const { return parents[entry]; }
+    [[nodiscard]] std::uint32_t nameId(std::uint32_t entry) const { return nameIds[entry]; }
+    [[nodiscard]] std::size_t nameCount() const { return nameOffsets.size() - 1; }
+    [[nodiscard]] std::string_view name(std::uint32_t id) const;
+    // Full path of `entry`, built in one piece inside `arena`.
+    [[nodiscard]] std::string_view pathOf(std::uint32_t entry, Arena& arena) const;
+    [[nodiscard]] const std::filesystem::path& root() const { return rootPath; }
+
+    // Children of directory `entry` as a [first, last) entry range.
+    [[nodiscard]] std::pair<std::uint32_t, std::uint32_t> children(std::uint32_t entry) const;
+    // Entry for `path` if it is inside the snapshot, else NO_PARENT.
+    [[nodiscard]] std::uint32_t lookup(const std::filesystem::path& path) const;
+
+    // True while no directory's mtime has changed since the snapshot. The
+    // checks are spread over `pool` when one is given.
+    [[nodiscard]] bool isCurrent(WorkStealingPool* pool = nullptr) const;
+    // Same check for the single directory `entry`, enough to trust its children.
+    [[nodiscard]] bool isCurrent(std::uint32_t entry) const;
+
+private:
+    friend std::pair<std::shared_ptr<const TreeSnapshot>, FileError> buildSnapshot(const std::filesystem::path& root, WorkStealingPool* pool);
+
+    std::filesystem::path rootPath;
+    std::vector<std::uint32_t> nameIds;
+    std::vector<std::uint32_t> parents;
+    std::vector<EntryType> types;
+    std::vector<std::uint32_t> dirSlot;
+
+    std::string namePool;
+    std::vector<std::uint32_t> nameOffsets{0};
+
+    std::vector<std::uint32_t> childBegin;
+    std::vector<std::uint32_t> childEnd;
+    std::vector<std::int64_t> dirMtimes;
+    std::vector<std::string> dirPaths;
+};
+
+// Reads the tree one depth level at a time. With a pool, the directories of
+// a level are read in parallel and appended in order afterwards, so the
+// result is the same as a sequential build.
+[[nodiscard]] std::pair<std::shared_ptr<const TreeSnapshot>, FileError> buildSnapshot(const std::filesystem::path& root, WorkStealingPool* pool = nullptr);
+
+// Session-wide cache: returns the snapshot for `root`, rebuilding it when a
+// directory mtime shows the tree changed. Directory reads and mtime checks
+// use `threads` threads. With `trusted` a cached snapshot is returned
+// without the mtime check; the caller drops stale ones via dropSnapshots.
+[[nodiscard]] std::pair<std::shared_ptr<const TreeSnapshot>, FileError> snapshotFor(const std::filesystem::path& root, std::size_t threads = 1, bool trusted = false);
+// Forgets cached snapshots that contain `path` or lie below it.
+void dropSnapshots(const std::filesystem::path& path);
+// A cached snapshot containing `path` (its entry goes to `entry`), or nullptr.
+// Callers check freshness of the part they use.
+[[nodiscard]] std::shared_ptr<const TreeSnapshot> cachedSnapshotContaining(const std::filesystem::path& path, std::uint32_t& entry);
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "config.hpp"
+#include "errors.hpp"
+
+struct IndexedFile{
+    std::string path;
+    std::int64_t mtime = 0;
+    std::uint64_t size = 0;
+    bool binary = false;
+    bool deleted = false;
+};
+
+struct IndexedDir{
+    std::string path;
+    std::int64_t mtime = 0;
+};
+
+// On-disk trigram index of a directory tree. Paths are stored relative to
+// `root`; each posting list holds delta-encoded varint file ids. Updated
+// files get a fresh id appended to their lists and leave a deleted entry
+// behind until compactIndex rewrites the lists.
+struct TrigramIndex{
+    std::filesystem::path root;
+    std::vector<IndexedFile> files;
+    std::vector<IndexedDir> dirs;
+    std::unordered_map<std::uint32_t, std::string> postings;
+
+    std::unordered_map<std::string, std::uint32_t> fileIds;
+    std::unordered_map<std::uint32_t, std::uint32_t> postingTails;
+    std::size_t deletedCount = 0;
+};
+
+[[nodiscard]] std::pair<TrigramIndex, FileError> buildIndex(const std::filesystem::path& root);
+[[nodiscard]] FileError saveIndex(const TrigramIndex& index);
+[[nodiscard]] std::pair<TrigramIndex, FileError> loadIndex(const std::filesystem::path& root);
+// loadIndex, but kept in memory and shared by later calls until the index
+// file's size or mtime changes.
+[[nodiscard]] std::pair<std::shared_ptr<const TrigramIndex>, FileError> loadSharedIndex(const std::filesystem::path& root);
+
+// Files under `prefix` (relative to the index root) that may contain every
+// trigram in `trigrams` (sorted, as from literalTrigrams). With
+// `verifyFreshness`, files whose size or mtime changed since the build and
+// files created since are included as well.
+[[nodiscard]] std::vector<std::filesystem::path> indexCandidates(const TrigramIndex& index, const std::vector<std::uint32_t>& trigrams, const SearchConfig& config,
+                                                                 const std::string& prefix = "", bool verifyFreshness = true);
+
+// Incremental maintenance. `rel` is relative to the index root.
+void updateIndexedFile(TrigramIndex& index, const std::string& rel);
+void removeIndexedPath(TrigramIndex& index, const std::string& rel);
+void addIndexedTree(TrigramIndex& index, const std::string& rel);
+void refreshIndex(TrigramIndex& index);
+void compactIndex(TrigramIndex& index);
+void refreshDirTimes(TrigramIndex& index);
+
+// Sets `rel` to `path` relative to the index root; false if outside it.
+[[nodiscard]] bool indexRelativePath(const TrigramIndex& index, const std::filesystem::path& path, std::string& rel);
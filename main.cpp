@@ -1,26 +1,71 @@
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <filesystem>
 #include "input_utils.hpp"
 #include "commands.hpp"
+#include "file_utils.hpp"
+#include "index_watcher.hpp"
 
-int main(){
-std::cout << "\n--- CLI File Manager v1.0 ---\n";
-std::cout << "Current directory: " << std::filesystem::current_path().string() << "\n";
-std::cout << "Type 'help' for commands or 'exit' to quit.\n";
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+// Runs commands from `in` until `exit` or end of input. Without prompts the
+// banner and '> ' are left out, and blank lines and '#' comments are skipped.
+void runSession(std::istream& in, bool interactive){
+    if(interactive){
+        std::cout << "\n--- CLI File Manager v1.0 ---\n";
+        std::cout << "Current directory: " << std::filesystem::current_path().string() << "\n";
+        std::cout << "Type 'help' for commands or 'exit' to quit.\n";
+    }
     std::string input;
 
     while(true){
-        std::cout << "\n> ";
-        
-        if(!std::getline(std::cin, input)){
-            std::cout << "\nExiting program.\n";
+        if(interactive) std::cout << "\n> ";
+
+        if(!std::getline(in, input)){
+            if(interactive) std::cout << "\nExiting program.\n";
             break;
         }
+        if(!interactive){
+            if(!input.empty() && input.back() == '\r') input.pop_back();
+            size_t start = input.find_first_not_of(" \t");
+            if(start == std::string::npos || input[start] == '#') continue;
+        }
 
         const Command inputResult = matchCommand(input);
         if(inputResult == Command::Exit) break;
-        executeCommand(inputResult, input);
+        executeCommand(inputResult, input, in);
     }
+}
+
+int main(int argc, char** argv){
+    std::string batchFile;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--batch" && i + 1 < argc){
+            batchFile = argv[++i];
+        }else{
+            std::cerr << "[ERROR] Usage: " << argv[0] << " [--batch FILE]\n";
+            return 1;
+        }
+    }
+
+    if(!batchFile.empty() && batchFile != "-"){
+        if(!handleFileError(checkFile(batchFile))) return 1;
+        std::ifstream commands(batchFile);
+        if(!commands && !handleFileError(FileError::OpenFailure)) return 1;
+        runSession(commands, false);
+    }else{
+        bool interactive = batchFile.empty();
+#if defined(__unix__) || defined(__APPLE__)
+        // Commands piped in on stdin run as a batch too.
+        if(interactive) interactive = isatty(STDIN_FILENO) == 1;
+#endif
+        runSession(std::cin, interactive);
+    }
+
+    if(!handleFileError(stopWatching())) return 1;
     return 0;
 }
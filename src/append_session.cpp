@@ -0,0 +1,141 @@
+#include <cerrno>
+#include <filesystem>
+#include "append_session.hpp"
+#include "file_utils.hpp"
+#include "index_watcher.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define APPEND_SESSION_POSIX 1
+#endif
+
+namespace{
+
+FileError errnoToWriteError(int err){
+    if(err == EACCES || err == EPERM) return FileError::PermissionDenied;
+    if(err == ENOENT) return FileError::FileNotFound;
+#ifdef EDQUOT
+    if(err == EDQUOT) return FileError::DiskFull;
+#endif
+    if(err == ENOSPC) return FileError::DiskFull;
+    return FileError::WriteFailure;
+}
+
+#ifdef APPEND_SESSION_POSIX
+int syncData(int fd){
+#ifdef __APPLE__
+    return ::fsync(fd);
+#else
+    return ::fdatasync(fd);
+#endif
+}
+#endif
+
+}
+
+AppendSession::~AppendSession(){
+    (void)close();
+}
+
+FileError AppendSession::open(const std::string& filename){
+    FileError checkResult = checkFile(filename);
+    if(checkResult != FileError::Ok) return checkResult;
+
+    std::error_code ec;
+    auto perms = std::filesystem::status(filename, ec).permissions();
+    if(!ec && (perms & std::filesystem::perms::owner_write) == std::filesystem::perms::none){
+        return FileError::PermissionDenied;
+    }
+#ifdef APPEND_SESSION_POSIX
+    fd = ::open(filename.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if(fd < 0) return errnoToWriteError(errno);
+#else
+    file = std::fopen(filename.c_str(), "ab");
+    if(!file) return FileError::WriteFailure;
+#endif
+    path = filename;
+    pending.reserve(APPEND_BUFFER_SIZE);
+    // With Always every append writes through itself, so no batch waits.
+    if(policy != SyncPolicy::Always) flusher = std::thread(&AppendSession::runFlusher, this);
+    return FileError::Ok;
+}
+
+FileError AppendSession::append(std::string_view line){
+    std::lock_guard<std::mutex> lock(mtx);
+    if(error != FileError::Ok) return error;
+
+    if(pending.empty()){
+        firstPending = std::chrono::steady_clock::now();
+        wake.notify_one();
+    }
+    pending.append(line);
+    pending.push_back('\n');
+    if(policy == SyncPolicy::Always || pending.size() >= APPEND_BUFFER_SIZE) flushLocked();
+    return error;
+}
+
+FileError AppendSession::close(){
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_one();
+    if(flusher.joinable()) flusher.join();
+
+    std::lock_guard<std::mutex> lock(mtx);
+#ifdef APPEND_SESSION_POSIX
+    if(fd < 0) return error;
+    flushLocked();
+    if(::close(fd) != 0 && error == FileError::Ok) error = errnoToWriteError(errno);
+    fd = -1;
+#else
+    if(!file) return error;
+    flushLocked();
+    if(std::fclose(file) != 0 && error == FileError::Ok) error = FileError::WriteFailure;
+    file = nullptr;
+#endif
+    if(dirty) noteFileChanged(path);
+    dirty = false;
+    return error;
+}
+
+void AppendSession::runFlusher(){
+    std::unique_lock<std::mutex> lock(mtx);
+    while(true){
+        wake.wait(lock, [this]{ return stopping || !pending.empty(); });
+        if(stopping) return;
+        // Give the batch until its oldest line is due to fill up further.
+        wake.wait_until(lock, firstPending + APPEND_FLUSH_INTERVAL, [this]{ return stopping || pending.empty(); });
+        if(stopping) return;
+        flushLocked();
+    }
+}
+
+// Writes the whole buffer and syncs it unless the policy is None. The
+// first failure sticks and later calls do nothing.
+void AppendSession::flushLocked(){
+    if(pending.empty() || error != FileError::Ok) return;
+#ifdef APPEND_SESSION_POSIX
+    std::string_view rest = pending;
+    while(!rest.empty()){
+        ssize_t n = ::write(fd, rest.data(), rest.size());
+        if(n < 0){
+            if(errno == EINTR) continue;
+            error = errnoToWriteError(errno);
+            return;
+        }
+        rest.remove_prefix(static_cast<std::size_t>(n));
+    }
+    dirty = true;
+    pending.clear();
+    if(policy != SyncPolicy::None && syncData(fd) != 0) error = errnoToWriteError(errno);
+#else
+    if(std::fwrite(pending.data(), 1, pending.size(), file) != pending.size() || std::fflush(file) != 0){
+        error = FileError::WriteFailure;
+        return;
+    }
+    dirty = true;
+    pending.clear();
+#endif
+}
@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "config.hpp"
+#include "arena.hpp"
+
+void* Arena::allocate(std::size_t bytes, std::size_t align){
+    auto aligned = [&]{
+        std::uintptr_t at = reinterpret_cast<std::uintptr_t>(cursor);
+        return reinterpret_cast<char*>((at + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1));
+    };
+    char *start = cursor ? aligned() : nullptr;
+    if(!start || bytes > static_cast<std::size_t>(limit - start)){
+        grow(bytes + align);
+        start = aligned();
+    }
+    cursor = start + bytes;
+    usedBytes += bytes;
+    return start;
+}
+
+std::string_view Arena::copy(std::string_view text){
+    char *out = static_cast<char*>(allocate(text.size() + 1, 1));
+    std::memcpy(out, text.data(), text.size());
+    out[text.size()] = '\0';
+    return {out, text.size()};
+}
+
+std::string_view Arena::joinPath(std::string_view dir, std::string_view name){
+    bool separator = !dir.empty() && dir.back() != '/';
+    std::size_t size = dir.size() + separator + name.size();
+    char *out = static_cast<char*>(allocate(size + 1, 1));
+    std::memcpy(out, dir.data(), dir.size());
+    if(separator) out[dir.size()] = '/';
+    std::memcpy(out + dir.size() + separator, name.data(), name.size());
+    out[size] = '\0';
+    return {out, size};
+}
+
+void Arena::reset(){
+    if(blocks.size() > 1) blocks.resize(1);
+    cursor = blocks.empty() ? nullptr : blocks.front().data.get();
+    limit = blocks.empty() ? nullptr : cursor + blocks.front().size;
+    usedBytes = 0;
+}
+
+void Arena::grow(std::size_t minBytes){
+    // Blocks double so a long command needs few of them.
+    std::size_t size = std::max(minBytes, blocks.empty() ? ARENA_BLOCK_SIZE : blocks.back().size * 2);
+    blocks.push_back({std::unique_ptr<char[]>(new char[size]), size});
+    cursor = blocks.back().data.get();
+    limit = cursor + size;
+}
+
+Arena& threadArena(){
+    thread_local Arena arena;
+    return arena;
+}
@@ -0,0 +1,448 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "async_reader.hpp"
+#include "config.hpp"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define ASYNC_READER_URING 1
+#endif
+
+#ifdef ASYNC_READER_URING
+namespace{
+
+enum Op : std::uint64_t{
+    OpOpen = 0,
+    OpRead = 1,
+    OpClose = 2,
+};
+
+std::uint64_t tag(std::size_t slot, Op op){
+    return (static_cast<std::uint64_t>(slot) << 2) | op;
+}
+
+FileError errnoToFileError(int err){
+    if(err == EACCES || err == EPERM) return FileError::PermissionDenied;
+    if(err == ENOENT) return FileError::FileNotFound;
+    return FileError::OpenFailure;
+}
+
+int uringSetup(unsigned entries, io_uring_params* params){
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags){
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int uringRegister(int fd, unsigned opcode, void* arg, unsigned count){
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+// Operations the reader queues. OPENAT, READ and CLOSE arrived in 5.6,
+// together with IORING_REGISTER_PROBE itself, and IOSQE_IO_HARDLINK in 5.5,
+// so a kernel that answers the probe with all three supports the link too.
+constexpr std::uint8_t REQUIRED_OPS[] = {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE};
+
+bool supportsRequiredOps(int fd){
+    constexpr unsigned probeOps = 256;
+    std::vector<char> storage(sizeof(io_uring_probe) + probeOps * sizeof(io_uring_probe_op), 0);
+    auto *probe = reinterpret_cast<io_uring_probe*>(storage.data());
+    if(uringRegister(fd, IORING_REGISTER_PROBE, probe, probeOps) < 0) return false;
+    for(std::uint8_t op : REQUIRED_OPS){
+        if(op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+    }
+    return true;
+}
+
+}
+
+// The mapped submission and completion rings. Entries are queued with
+// nextSqe() and handed to the kernel together by submit().
+struct AsyncFileReader::Ring{
+    int fd = -1;
+    void *sqMap = MAP_FAILED;
+    void *cqMap = MAP_FAILED;
+    void *sqeMap = MAP_FAILED;
+    std::size_t sqMapSize = 0;
+    std::size_t cqMapSize = 0;
+    std::size_t sqeMapSize = 0;
+
+    unsigned *sqHead = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned *sqMask = nullptr;
+    unsigned *sqArray = nullptr;
+    unsigned sqEntries = 0;
+    unsigned localTail = 0;
+    io_uring_sqe *sqes = nullptr;
+
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned *cqMask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+    bool init(unsigned entries){
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = uringSetup(entries, &params);
+        if(fd < 0) return false;
+
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if(singleMap) sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+
+        sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if(sqMap == MAP_FAILED) return false;
+        if(singleMap){
+            cqMap = sqMap;
+        }else{
+            cqMap = mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if(cqMap == MAP_FAILED) return false;
+        }
+        sqeMapSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqeMap = mmap(nullptr, sqeMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if(sqeMap == MAP_FAILED) return false;
+
+        char *sq = static_cast<char*>(sqMap);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sqEntries = params.sq_entries;
+        localTail = *sqTail;
+        sqes = static_cast<io_uring_sqe*>(sqeMap);
+
+        char *cq = static_cast<char*>(cqMap);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    ~Ring(){
+        if(sqeMap != MAP_FAILED) munmap(sqeMap, sqeMapSize);
+        if(cqMap != MAP_FAILED && cqMap != sqMap) munmap(cqMap, cqMapSize);
+        if(sqMap != MAP_FAILED) munmap(sqMap, sqMapSize);
+        if(fd >= 0) close(fd);
+    }
+
+    [[nodiscard]] unsigned space() const{
+        return sqEntries - (localTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE));
+    }
+
+    // Caller checks space() first.
+    io_uring_sqe* nextSqe(){
+        unsigned index = localTail & *sqMask;
+        sqArray[index] = index;
+        ++localTail;
+        io_uring_sqe *sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // Hands queued entries to the kernel and waits for `waitFor` completions.
+    bool submit(unsigned waitFor){
+        unsigned toSubmit = localTail - *sqTail;
+        __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+        while(true){
+            int r = uringEnter(fd, toSubmit, waitFor, waitFor ? IORING_ENTER_GETEVENTS : 0);
+            if(r >= 0) return true;
+            if(errno == EINTR) continue;
+            // The completion queue is full; the caller reaps and comes back.
+            return errno == EBUSY || errno == EAGAIN;
+        }
+    }
+
+    template <typename Handle>
+    void reap(Handle&& handle){
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        while(head != tail){
+            const io_uring_cqe &cqe = cqes[head & *cqMask];
+            std::uint64_t data = cqe.user_data;
+            int res = cqe.res;
+            ++head;
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+            handle(data, res);
+            tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        }
+    }
+};
+
+AsyncFileReader::AsyncFileReader(std::size_t queueDepth, std::size_t maxSize, bool (*skip)(const FileIdentity&))
+    : depth(std::max<std::size_t>(1, queueDepth)), maxSize(maxSize), skip(skip), paths(depth * 16), results(depth){
+    ring = std::make_unique<Ring>();
+    // Each slot has at most a read and a close queued at once.
+    if(!ring->init(static_cast<unsigned>(depth * 2))){
+        ring.reset();
+        return;
+    }
+    ready = true;
+    worker = std::thread([this]{ run(); });
+}
+
+AsyncFileReader::~AsyncFileReader(){
+    paths.close();
+    results.close();
+    if(worker.joinable()) worker.join();
+    // The ring goes before the buffers its requests point into.
+    ring.reset();
+}
+
+void AsyncFileReader::run(){
+    struct Slot{
+        std::string_view path;
+        std::unique_ptr<char[]> buffer;
+        FileIdentity identity;
+        unsigned pending = 0;
+    };
+    std::vector<Slot> slots(depth);
+    std::vector<std::size_t> freeSlots;
+    for(std::size_t i = depth; i > 0; --i) freeSlots.push_back(i - 1);
+    std::size_t busy = 0;
+    bool inputDone = false;
+    bool stopping = false;
+    bool failed = false;
+
+    auto release = [&](std::size_t s){
+        freeSlots.push_back(s);
+        --busy;
+    };
+    auto deliver = [&](AsyncReadFile file){
+        if(!results.push(std::move(file))) stopping = true;
+    };
+
+    while(true){
+        while(!freeSlots.empty() && !inputDone && !stopping){
+            std::string_view path;
+            if(busy == 0){
+                if(!paths.pop(path)){
+                    inputDone = true;
+                    break;
+                }
+            }else if(!paths.tryPop(path)){
+                break;
+            }
+            if(ring->space() == 0){
+                AsyncReadFile file;
+                file.path = path;
+                file.deferred = true;
+                deliver(std::move(file));
+                break;
+            }
+            io_uring_sqe *sqe = ring->nextSqe();
+            std::size_t s = freeSlots.back();
+            freeSlots.pop_back();
+            ++busy;
+            Slot &slot = slots[s];
+            slot.path = path;
+            slot.pending = 1;
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<std::uint64_t>(slot.path.data());
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = tag(s, OpOpen);
+        }
+        if(busy == 0){
+            if(inputDone || stopping) break;
+            continue;
+        }
+
+        if(!ring->submit(1)){
+            failed = true;
+            break;
+        }
+        ring->reap([&](std::uint64_t data, int res){
+            std::size_t s = static_cast<std::size_t>(data >> 2);
+            Slot &slot = slots[s];
+            --slot.pending;
+
+            switch(static_cast<Op>(data & 3)){
+                case OpOpen:{
+                    // EINVAL means the kernel does not know the opcode after
+                    // all; the consumer opens the file itself.
+                    if(res == -EINVAL){
+                        AsyncReadFile file;
+                        file.path = std::exchange(slot.path, {});
+                        file.deferred = true;
+                        deliver(std::move(file));
+                        release(s);
+                        break;
+                    }
+                    if(res < 0){
+                        AsyncReadFile file;
+                        file.path = std::exchange(slot.path, {});
+                        file.error = errnoToFileError(-res);
+                        deliver(std::move(file));
+                        release(s);
+                        break;
+                    }
+                    // The size decides before any data is read. A file the
+                    // buffer cannot hold goes to the consumer unread, as does
+                    // one fstat fails on. Each slot has room for its read and
+                    // close, so the space check is only a safety net.
+                    AsyncReadFile file;
+                    bool known = statIdentity(res, file.identity);
+                    if(known && file.identity.size > maxSize){
+                        file.error = FileError::FileTooLarge;
+                    }else if(known && skip && skip(file.identity)){
+                        file.error = FileError::Skipped;
+                    }else if(!known || file.identity.size >= ASYNC_READ_BUFFER_SIZE || ring->space() < 2){
+                        file.deferred = true;
+                    }
+                    if(file.error != FileError::Ok || file.deferred){
+                        ::close(res);
+                        file.path = std::exchange(slot.path, {});
+                        deliver(std::move(file));
+                        release(s);
+                        break;
+                    }
+                    slot.identity = file.identity;
+                    slot.buffer = takeBuffer();
+                    io_uring_sqe *read = ring->nextSqe();
+                    io_uring_sqe *close = ring->nextSqe();
+                    read->opcode = IORING_OP_READ;
+                    read->fd = res;
+                    read->addr = reinterpret_cast<std::uint64_t>(slot.buffer.get());
+                    read->len = static_cast<std::uint32_t>(ASYNC_READ_BUFFER_SIZE);
+                    read->off = 0;
+                    // A hard link runs the close even after a short read.
+                    read->flags = IOSQE_IO_HARDLINK;
+                    read->user_data = tag(s, OpRead);
+                    close->opcode = IORING_OP_CLOSE;
+                    close->fd = res;
+                    close->user_data = tag(s, OpClose);
+                    slot.pending = 2;
+                    break;
+                }
+                case OpRead:{
+                    AsyncReadFile file;
+                    file.path = std::exchange(slot.path, {});
+                    file.identity = slot.identity;
+                    if(res < 0){
+                        file.error = FileError::ReadFailure;
+                    }else if(static_cast<std::size_t>(res) >= ASYNC_READ_BUFFER_SIZE){
+                        file.deferred = true;
+                    }else if(static_cast<std::size_t>(res) > maxSize){
+                        file.error = FileError::FileTooLarge;
+                    }else{
+                        file.buffer = std::move(slot.buffer);
+                        file.size = static_cast<std::size_t>(res);
+                    }
+                    deliver(std::move(file));
+                    if(slot.buffer){
+                        AsyncReadFile unused;
+                        unused.buffer = std::move(slot.buffer);
+                        recycle(unused);
+                    }
+                    if(slot.pending == 0) release(s);
+                    break;
+                }
+                default:
+                    if(slot.pending == 0) release(s);
+                    break;
+            }
+        });
+    }
+
+    if(failed){
+        // The ring stopped working: consumers read the remaining files
+        // themselves. Buffers the kernel may still own are parked in the
+        // free list, which outlives the ring.
+        for(auto &slot : slots){
+            if(slot.buffer){
+                std::lock_guard<std::mutex> lock(bufferMtx);
+                freeBuffers.push_back(std::move(slot.buffer));
+            }
+            if(slot.pending > 0 && !slot.path.empty()){
+                AsyncReadFile file;
+                file.path = std::exchange(slot.path, {});
+                file.deferred = true;
+                if(!results.push(std::move(file))) break;
+            }
+        }
+        std::string_view path;
+        while(!inputDone && paths.pop(path)){
+            AsyncReadFile file;
+            file.path = path;
+            file.deferred = true;
+            if(!results.push(std::move(file))) break;
+        }
+    }
+    results.close();
+}
+
+std::unique_ptr<char[]> AsyncFileReader::takeBuffer(){
+    {
+        std::lock_guard<std::mutex> lock(bufferMtx);
+        if(!freeBuffers.empty()){
+            std::unique_ptr<char[]> buffer = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+            return buffer;
+        }
+    }
+    return std::unique_ptr<char[]>(new char[ASYNC_READ_BUFFER_SIZE]);
+}
+
+bool asyncReadAvailable(){
+    static const bool available = []{
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = uringSetup(2, &params);
+        if(fd < 0) return false;
+        bool supported = supportsRequiredOps(fd);
+        close(fd);
+        return supported;
+    }();
+    return available;
+}
+
+#else
+
+struct AsyncFileReader::Ring{};
+
+AsyncFileReader::AsyncFileReader(std::size_t queueDepth, std::size_t maxSize, bool (*skip)(const FileIdentity&))
+    : depth(queueDepth), maxSize(maxSize), skip(skip), paths(1), results(1) {}
+
+AsyncFileReader::~AsyncFileReader() = default;
+
+void AsyncFileReader::run() {}
+
+std::unique_ptr<char[]> AsyncFileReader::takeBuffer(){
+    return std::unique_ptr<char[]>(new char[ASYNC_READ_BUFFER_SIZE]);
+}
+
+bool asyncReadAvailable(){
+    return false;
+}
+
+#endif
+
+void AsyncFileReader::submit(std::string_view path){
+    paths.push(path);
+}
+
+void AsyncFileReader::finish(){
+    paths.close();
+}
+
+bool AsyncFileReader::next(AsyncReadFile& out){
+    return results.pop(out);
+}
+
+void AsyncFileReader::recycle(AsyncReadFile& file){
+    if(!file.buffer) return;
+    std::lock_guard<std::mutex> lock(bufferMtx);
+    if(freeBuffers.size() < depth * 2) freeBuffers.push_back(std::move(file.buffer));
+    file.buffer.reset();
+}
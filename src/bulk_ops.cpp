@@ -0,0 +1,223 @@
+#include <cerrno>
+#include <charconv>
+#include <iostream>
+#include <mutex>
+#include <string_view>
+#include "bulk_ops.hpp"
+#include "file_utils.hpp"
+#include "index_watcher.hpp"
+#include "output_sink.hpp"
+#include "regex_utils.hpp"
+#include "result_format.hpp"
+#include "thread_pool.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define BULK_OPS_POSIX 1
+#endif
+
+namespace{
+
+#ifdef BULK_OPS_POSIX
+FileError errnoToFileError(int err, FileError fallback){
+    if(err == EACCES || err == EPERM || err == EROFS) return FileError::PermissionDenied;
+    if(err == ENOENT) return FileError::FileNotFound;
+    if(err == EEXIST) return FileError::FileExists;
+    if(err == ENOTDIR) return FileError::NotADirectory;
+    if(err == ENOSPC) return FileError::DiskFull;
+    return fallback;
+}
+
+FileError createAt(int dirFd, const char* name){
+    int fd = ::openat(dirFd, name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if(fd < 0) return errnoToFileError(errno, FileError::CreateFailure);
+    ::close(fd);
+    return FileError::Ok;
+}
+
+FileError removeAt(int dirFd, const char* name){
+    if(::unlinkat(dirFd, name, 0) != 0) return errnoToFileError(errno, FileError::DeletionFailure);
+    return FileError::Ok;
+}
+#endif
+
+// Runs `op` on every path, which must be NUL-terminated, and passes each
+// one that succeeds to `note`. On POSIX every parent directory is opened
+// once for the run of paths that share it, and `op` gets that fd with the
+// bare name; elsewhere it gets -1 and the whole path.
+template <typename Paths>
+void applyInDirectories(const Paths& paths, FileError (*op)(int, const char*), void (*note)(const std::filesystem::path&), BulkSummary& summary){
+#ifdef BULK_OPS_POSIX
+    std::string_view openDir;
+    bool opened = false;
+    int dirFd = -1;
+    FileError dirErr = FileError::Ok;
+    for(const auto &item : paths){
+        std::string_view path = item;
+        std::size_t slash = path.rfind('/');
+        std::string_view parent = slash == std::string_view::npos ? std::string_view() : path.substr(0, slash == 0 ? 1 : slash);
+
+        if(!opened || parent != openDir){
+            if(dirFd >= 0) ::close(dirFd);
+            opened = true;
+            openDir = parent;
+            dirErr = FileError::Ok;
+            if(parent.empty()){
+                dirFd = AT_FDCWD;
+            }else{
+                dirFd = ::open(std::string(parent).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+                if(dirFd < 0) dirErr = errnoToFileError(errno, FileError::PathNotFound);
+            }
+        }
+
+        FileError err = dirErr != FileError::Ok ? dirErr : op(dirFd, path.data() + (slash == std::string_view::npos ? 0 : slash + 1));
+        if(err != FileError::Ok){
+            summary.fail(err, path);
+            continue;
+        }
+        ++summary.done;
+        note(std::filesystem::path(path));
+    }
+    if(dirFd >= 0) ::close(dirFd);
+#else
+    for(const auto &item : paths){
+        std::string_view path = item;
+        FileError err = op(-1, path.data());
+        if(err != FileError::Ok){
+            summary.fail(err, path);
+            continue;
+        }
+        ++summary.done;
+        note(std::filesystem::path(path));
+    }
+#endif
+}
+
+FileError createOne(int dirFd, const char* name){
+#ifdef BULK_OPS_POSIX
+    return createAt(dirFd, name);
+#else
+    (void)dirFd;
+    return createFile(name);
+#endif
+}
+
+FileError removeOne(int dirFd, const char* name){
+#ifdef BULK_OPS_POSIX
+    return removeAt(dirFd, name);
+#else
+    (void)dirFd;
+    return deleteFile(name);
+#endif
+}
+
+}
+
+void BulkSummary::fail(FileError err, std::string_view path){
+    ++failed;
+    auto &entry = errors[err];
+    if(entry.first++ == 0) entry.second = path;
+}
+
+void BulkSummary::merge(const BulkSummary& other){
+    done += other.done;
+    failed += other.failed;
+    for(const auto &[err, entry] : other.errors){
+        auto &mine = errors[err];
+        if(mine.first == 0) mine.second = entry.second;
+        mine.first += entry.first;
+    }
+}
+
+std::pair<std::vector<std::string>, InputError> expandNameRange(std::string_view name){
+    std::size_t open = name.find('{');
+    std::size_t dots = name.find("..", open);
+    std::size_t close = name.find('}', dots);
+    if(open == std::string_view::npos || dots == std::string_view::npos || close == std::string_view::npos) return {{std::string(name)}, InputError::Ok};
+
+    std::string_view first(name.data() + open + 1, dots - open - 1);
+    std::string_view last(name.data() + dots + 2, close - dots - 2);
+    std::uint64_t from = 0, to = 0;
+    auto [firstEnd, firstEc] = std::from_chars(first.data(), first.data() + first.size(), from);
+    auto [lastEnd, lastEc] = std::from_chars(last.data(), last.data() + last.size(), to);
+    if(first.empty() || last.empty() || firstEc != std::errc() || lastEc != std::errc()
+       || firstEnd != first.data() + first.size() || lastEnd != last.data() + last.size()){
+        return {{std::string(name)}, InputError::Ok};
+    }
+    if(to < from) std::swap(from, to);
+    if(to - from >= MAX_BULK_CREATE) return {{}, InputError::InputTooLong};
+
+    std::size_t width = first.size() > 1 && first[0] == '0' ? first.size() : 0;
+    std::string_view prefix(name.data(), open);
+    std::string_view suffix(name.data() + close + 1, name.size() - close - 1);
+
+    std::vector<std::string> names;
+    names.reserve(static_cast<std::size_t>(to - from + 1));
+    char digits[20];
+    for(std::uint64_t n = from; ; ++n){
+        auto end = std::to_chars(digits, digits + sizeof(digits), n).ptr;
+        std::size_t length = static_cast<std::size_t>(end - digits);
+
+        std::string &out = names.emplace_back();
+        out.reserve(prefix.size() + std::max(width, length) + suffix.size());
+        out.append(prefix);
+        if(length < width) out.append(width - length, '0');
+        out.append(digits, length);
+        out.append(suffix);
+        if(n == to) break;
+    }
+    return {std::move(names), InputError::Ok};
+}
+
+void createFiles(const std::vector<std::string>& names, std::size_t threads, BulkSummary& summary){
+    WorkStealingPool pool(threads);
+    std::mutex summaryMtx;
+    parallelFor(pool, names.size(), 256, [&](std::size_t begin, std::size_t end){
+        BulkSummary local;
+        std::vector<std::string_view> chunk(names.begin() + begin, names.begin() + end);
+        applyInDirectories(chunk, createOne, noteFileChanged, local);
+
+        std::lock_guard<std::mutex> lock(summaryMtx);
+        summary.merge(local);
+    });
+}
+
+RegexError deleteMatching(const Matcher& matcher, const BulkConfig& config, BulkSummary& summary, const std::filesystem::path& start){
+    FindConfig findConfig;
+    findConfig.threads = config.threads;
+    findConfig.maxDepth = config.maxDepth;
+    findConfig.useIgnore = config.useIgnore;
+    findConfig.sorted = config.dryRun;
+
+    // Every batch from the snapshot holds one directory's files, so each
+    // worker unlinks through a single directory fd.
+    std::mutex summaryMtx;
+    return findFilesByName(matcher, findConfig, [&](std::vector<std::string_view>& files){
+        BulkSummary local;
+        if(config.dryRun){
+            OutputBuffer &output = threadOutputBuffer();
+            output.clear();
+            for(const auto &path : files){
+                appendPathRecord(output, OutputFormat::Text, path);
+                if(output.size() >= OUTPUT_BUFFER_SIZE) writeOutput(output);
+            }
+            writeOutput(output);
+            local.done = files.size();
+        }else{
+            applyInDirectories(files, removeOne, noteFileRemoved, local);
+        }
+
+        std::lock_guard<std::mutex> lock(summaryMtx);
+        summary.merge(local);
+    }, start);
+}
+
+void reportBulkSummary(const BulkSummary& summary, const char* verb){
+    flushOutput();
+    std::cout << "[INFO] " << verb << ' ' << summary.done << " of " << summary.done + summary.failed << " files.\n";
+    for(const auto &[err, entry] : summary.errors){
+        matchFileError(err);
+        std::cerr << "        " << entry.first << (entry.first == 1 ? " file" : " files") << ", first: '" << entry.second << "'\n";
+    }
+}
@@ -1,21 +1,54 @@
 #include <iostream>
+#include "config.hpp"
 #include "errors.hpp"
 #include "input_utils.hpp"
 #include "file_utils.hpp"
 #include "regex_utils.hpp"
 #include "flag_utils.hpp"
+#include "trigram_index.hpp"
+#include "index_watcher.hpp"
+#include "output_sink.hpp"
+#include "pattern_cache.hpp"
+#include "line_reader.hpp"
+#include "result_format.hpp"
+#include "bulk_ops.hpp"
+
+namespace{
+
+// Splits "<argument> --flag ..." before the first flag; the argument itself
+// may contain spaces.
+std::pair<std::string_view, std::string_view> splitArgument(std::string_view args){
+    size_t flagPos = args.rfind("--", 0) == 0 ? 0 : args.find(" --");
+    if(flagPos == std::string_view::npos) return {args, {}};
+    return {args.substr(0, flagPos), args.substr(flagPos == 0 ? 0 : flagPos + 1)};
+}
+
+// Applies every flag in `params` to `config`. Returns false once an error
+// has been reported.
+template<typename Config>
+bool applyFlags(std::string_view params, const FlagTable<Config>& table, Config& config){
+    return handleFlagError(parseFlags(params, table, config));
+}
 
-void executeCommand(const Command& cmd, const std::string& input){
+}
+
+void executeCommand(const Command& cmd, const std::string& input, std::istream& in){
         switch(cmd){
             case Command::Exit: break;
             case Command::Help:
                 showCommands();
                 break;
             case Command::Add:{
-                auto [file, err] = parseCommand(input);
-                if(!handleInputError(err)) break;
+                auto [args, inputErr] = parseCommand(input);
+                if(!handleInputError(inputErr)) break;
+
+                auto [file, params] = splitArgument(args);
+                if(!handleInputError(file.empty() ? InputError::EmptyField : InputError::Ok)) break;
 
-                handleEditCommand(file);
+                AppendConfig config;
+                if(!applyFlags(params, ADD_FLAGS, config)) break;
+
+                handleEditCommand(std::string(file), config, in);
                 break;
                                 }
             case Command::FlagDetails:{
@@ -23,94 +56,189 @@ void executeCommand(const Command& cmd, const std::string& input){
                 break;
                                       }
             case Command::Read:{
-                auto [file, inputErr] = parseCommand(input);
+                auto [args, inputErr] = parseCommand(input);
                 if(!handleInputError(inputErr)) break;
 
-                std::cout << "[INFO] Reading file: '" << file << "'\n";
-                auto [lines, fileErr] = readFileLines(file);
-                if(!handleFileError(fileErr)) break;
+                auto [file, params] = splitArgument(args);
+                if(!handleInputError(file.empty() ? InputError::EmptyField : InputError::Ok)) break;
 
-                for(size_t i = 0; i < lines.size(); ++i){
-                    std::cout << (i + 1) << ": " << lines[i] << "\n";
-                }
+                ReadConfig config;
+                if(!applyFlags(params, READ_FLAGS, config)) break;
+                // --tail picks its own start line.
+                if(!handleFlagError(config.tail != 0 && config.fromLine != 1 ? FlagError::InvalidValue : FlagError::Ok)) break;
 
-                std::cout << "[INFO] Total lines: " << lines.size() << "\n";
+                std::cout << "[INFO] Reading file: '" << file << "'\n";
+                FileError readResult = streamFileLines(std::string(file), config);
+                if(!handleFileError(readResult)) break;
                 break;
                                 }
             case Command::Create:{
-                auto [file, err] = parseCommand(input);
-                if(!handleInputError(err)) break;
+                auto [args, inputErr] = parseCommand(input);
+                if(!handleInputError(inputErr)) break;
+
+                auto [file, params] = splitArgument(args);
+                if(!handleInputError(file.empty() ? InputError::EmptyField : InputError::Ok)) break;
 
-                FileError createResult = createFile(file);
+                BulkConfig config;
+                if(!applyFlags(params, CREATE_FLAGS, config)) break;
+
+                auto [names, rangeErr] = expandNameRange(file);
+                if(!handleInputError(rangeErr)) break;
+                if(names.size() > 1){
+                    BulkSummary summary;
+                    createFiles(names, config.threads, summary);
+                    reportBulkSummary(summary, "Created");
+                    break;
+                }
+
+                FileError createResult = createFile(std::string(file));
                 if(handleFileError(createResult)){
                     std::cout << "[INFO] File '" << file << "' created.\n";
                 }
                 break;
                                  }
             case Command::List:{
+                auto [args, inputErr] = parseCommand(input);
+                ListConfig config;
+                if(inputErr != InputError::EmptyField){
+                    if(!handleInputError(inputErr) || !applyFlags(args, LIST_FLAGS, config)) break;
+                }
+
                 FileError listResult = listDirFiles();
                 if(!handleFileError(listResult)) break;
                 break;
                                }
             case Command::Find:{
-                auto [query, inputErr] = parseCommand(input);
+                auto [args, inputErr] = parseCommand(input);
                 if(!handleInputError(inputErr)) break;
 
-                auto [re, regErr] = compileRegex(query);
+                auto [query, params] = splitArgument(args);
+                FindConfig config;
+                if(!applyFlags(params, FIND_FLAGS, config)) break;
+
+                auto [re, regErr] = compileRegex(std::string(query));
                 if(!handleRegexError(regErr)) break;
 
-               auto [files,findErr]  = findFilesByName(re);
+                RegexError findErr = findFilesByName(*re, config, [&config](std::vector<std::string_view>& files){
+                    OutputBuffer &output = threadOutputBuffer();
+                    output.clear();
+                    for(const auto &filepath : files){
+                        appendPathRecord(output, config.format, filepath);
+                        if(output.size() >= OUTPUT_BUFFER_SIZE) writeOutput(output);
+                    }
+                    writeOutput(output);
+                });
                 if(!handleRegexError(findErr)) break;
-
-                for(const auto &filepath : files){
-                    std::cout << filepath << "\n";
-                }
                 break;
                                }
             case Command::Search:{
-                std::string_view querySV = extractQuery(input);
-                std::string query = std::string(querySV);
-                std::string_view params = skipWords(input);
+                auto [args, inputErr] = parseCommand(input);
+                if(!handleInputError(inputErr)) break;
 
+                auto [querySV, params] = splitArgument(args);
+                std::string flags = takeContextShorthand(querySV);
+                flags.append(flags.empty() || params.empty() ? "" : " ").append(params);
                 SearchConfig config;
+                if(!applyFlags(flags, SEARCH_FLAGS, config)) break;
 
-                if(!params.empty()){
-                    auto tokens = tokenize(params);
-
-                    auto [parsedArgs, flagErr] = splitFlag(tokens);
-                    if(!handleFlagError(flagErr)) break;
-
-                    bool flagError = false;
-                    for(const auto& arg : parsedArgs){
-                        FlagError applyFlagResult = applyFlag(arg, config);
-                        if(!handleFlagError(applyFlagResult)){
-                            flagError = true;
-                            break;
-                        }
-                    }
-                    if(flagError) break;
-                }
-
+                std::string query(querySV);
                 auto [re, regErr] = compileRegex(query);
                 if(!handleRegexError(regErr)) break;
 
-                RegexError res = findInFile(query, re, config);
+                RegexError res = findInFile(query, *re, config);
                 if(!handleRegexError(res)) break;
 
                 break;
                                  }
             case Command::Delete:{
-                auto [file, err] = parseCommand(input);
-                if(!handleInputError(err)) break;
+                auto [args, inputErr] = parseCommand(input);
+                if(!handleInputError(inputErr)) break;
+
+                auto [file, params] = splitArgument(args);
+                if(!params.empty()){
+                    // Bulk form: the argument, if any, is the directory to start from.
+                    BulkConfig config;
+                    if(!applyFlags(params, DELETE_FLAGS, config)) break;
+                    if(!handleFlagError(config.pattern.empty() ? FlagError::NoValue : FlagError::Ok)) break;
+
+                    auto [re, regErr] = compileRegex(std::string(config.pattern));
+                    if(!handleRegexError(regErr)) break;
+
+                    BulkSummary summary;
+                    std::error_code ec;
+                    RegexError deleteErr = deleteMatching(*re, config, summary, file.empty() ? std::filesystem::current_path() : std::filesystem::absolute(std::filesystem::path(file), ec));
+                    if(!handleRegexError(deleteErr)) break;
+                    reportBulkSummary(summary, config.dryRun ? "Would delete" : "Deleted");
+                    break;
+                }
 
-                FileError deleteResult = deleteFile(file);
+                FileError deleteResult = deleteFile(std::string(file));
                 if(handleFileError(deleteResult)){
                     std::cout << "[INFO] File '" << file << "' deleted.\n";
                 }
                 break;
                                  }
+            case Command::Index:{
+                auto [args, inputErr] = parseCommand(input);
+                if(!handleInputError(inputErr)) break;
+
+                auto tokens = tokenize(args);
+                if(tokens.empty() || tokens[0] != "build" || tokens.size() > 2){
+                    std::cout << "[ERROR] Usage: index build [dir]\n";
+                    break;
+                }
+                std::filesystem::path root = tokens.size() == 2 ? std::filesystem::path(std::string(tokens[1])) : std::filesystem::current_path();
+
+                auto [index, buildErr] = buildIndex(root);
+                if(!handleFileError(buildErr)) break;
+                FileError saveResult = saveIndex(index);
+                if(!handleFileError(saveResult)) break;
+
+                std::cout << "[INFO] Indexed " << index.files.size() << " files (" << index.postings.size()
+                          << " trigrams) into '" << (index.root / INDEX_FILE_NAME).string() << "'.\n";
+                break;
+                                }
+            case Command::Watch:{
+                auto tokens = tokenize(input);
+                if(tokens.size() > 2){
+                    std::cout << "[ERROR] Usage: watch [dir] | watch stop\n";
+                    break;
+                }
+                if(tokens.size() == 2 && tokens[1] == "stop"){
+                    FileError stopResult = stopWatching();
+                    if(handleFileError(stopResult)) std::cout << "[INFO] Stopped watching.\n";
+                    break;
+                }
+
+                std::filesystem::path root = tokens.size() == 2 ? std::filesystem::path(std::string(tokens[1])) : std::filesystem::current_path();
+                FileError watchResult = startWatching(root);
+                if(!handleFileError(watchResult)) break;
+
+                std::filesystem::path watched;
+                if(watchedRoot(watched)) std::cout << "[INFO] Watching '" << watched.string() << "'.\n";
+                break;
+                                }
+            case Command::Cache:{
+                auto tokens = tokenize(input);
+                if(tokens.size() == 2 && tokens[1] == "clear"){
+                    patternCache().clear();
+                    std::cout << "[INFO] Pattern cache cleared.\n";
+                    break;
+                }
+                if(tokens.size() == 3 && tokens[1] == "capacity"){
+                    uintmax_t capacity = 0;
+                    if(!handleFlagError(parseNumber(tokens[2], capacity))) break;
+                    patternCache().setCapacity(static_cast<std::size_t>(capacity));
+                }else if(tokens.size() != 1){
+                    std::cout << "[ERROR] Usage: cache [clear | capacity N]\n";
+                    break;
+                }
+                printPatternCacheStats();
+                break;
+                                }
             case Command::InvalidCommand:
                 std::cout << "[ERROR] Invalid command.\n";
                 break;
         };
+        flushOutput();
 }
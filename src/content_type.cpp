@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "config.hpp"
+#include "content_type.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define CONTENT_TYPE_SSE2 1
+#endif
+
+namespace{
+
+struct SampleScan{
+    bool nul = false;
+    std::size_t controls = 0;
+    bool highBytes = false;
+};
+
+// Control bytes that plain text does not use. Backspace, tab, newline,
+// vertical tab, form feed, carriage return and escape are allowed.
+inline bool isStrayControl(unsigned char c){
+    return c < 0x20 && !(c >= 0x08 && c <= 0x0d) && c != 0x1b;
+}
+
+SampleScan scanSample(const unsigned char* data, std::size_t n){
+    SampleScan scan;
+    std::size_t i = 0;
+#ifdef CONTENT_TYPE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maxControl = _mm_set1_epi8(0x1f);
+    const __m128i eight = _mm_set1_epi8(0x08);
+    const __m128i five = _mm_set1_epi8(0x05);
+    const __m128i escape = _mm_set1_epi8(0x1b);
+    unsigned high = 0;
+    for(; i + 16 <= n; i += 16){
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0){
+            scan.nul = true;
+            return scan;
+        }
+        // Unsigned `a <= b` is min(a, b) == a.
+        __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(v, maxControl), v);
+        __m128i shifted = _mm_sub_epi8(v, eight);
+        __m128i whitespace = _mm_cmpeq_epi8(_mm_min_epu8(shifted, five), shifted);
+        __m128i allowed = _mm_or_si128(whitespace, _mm_cmpeq_epi8(v, escape));
+        unsigned stray = static_cast<unsigned>(_mm_movemask_epi8(_mm_andnot_si128(allowed, control)));
+        scan.controls += static_cast<std::size_t>(__builtin_popcount(stray));
+        high |= static_cast<unsigned>(_mm_movemask_epi8(v));
+    }
+    scan.highBytes = high != 0;
+#endif
+    for(; i < n; ++i){
+        if(data[i] == 0){
+            scan.nul = true;
+            return scan;
+        }
+        scan.controls += isStrayControl(data[i]);
+        scan.highBytes |= data[i] >= 0x80;
+    }
+    return scan;
+}
+
+// Counts bytes that do not belong to a valid UTF-8 sequence. A sequence cut
+// off by the end of the sample is not counted.
+std::size_t invalidUtf8Bytes(const unsigned char* data, std::size_t n){
+    std::size_t invalid = 0;
+    std::size_t i = 0;
+    while(i < n){
+        unsigned char c = data[i];
+        if(c < 0x80){
+            ++i;
+            continue;
+        }
+        std::size_t length = 0;
+        unsigned char low = 0x80, high = 0xbf;
+        if(c >= 0xc2 && c <= 0xdf){
+            length = 2;
+        }else if(c >= 0xe0 && c <= 0xef){
+            length = 3;
+            if(c == 0xe0) low = 0xa0;
+            if(c == 0xed) high = 0x9f;
+        }else if(c >= 0xf0 && c <= 0xf4){
+            length = 4;
+            if(c == 0xf0) low = 0x90;
+            if(c == 0xf4) high = 0x8f;
+        }else{
+            ++invalid;
+            ++i;
+            continue;
+        }
+
+        std::size_t j = 1;
+        for(; j < length && i + j < n; ++j){
+            unsigned char next = data[i + j];
+            if(next < (j == 1 ? low : 0x80) || next > (j == 1 ? high : 0xbf)) break;
+        }
+        if(i + j == n && j < length) break;
+        if(j < length){
+            invalid += j;
+            i += j;
+            continue;
+        }
+        i += length;
+    }
+    return invalid;
+}
+
+struct Magic{
+    const char* bytes;
+    std::size_t size;
+};
+
+// Formats that may not show a NUL byte early but are never text.
+constexpr std::array<Magic, 12> BINARY_MAGICS{{
+    {"\x7f" "ELF", 4},
+    {"\x89PNG", 4},
+    {"GIF87a", 6},
+    {"GIF89a", 6},
+    {"\xff\xd8\xff", 3},
+    {"\x1f\x8b", 2},
+    {"PK\x03\x04", 4},
+    {"\xfd" "7zXZ", 5},
+    {"\x28\xb5\x2f\xfd", 4},
+    {"7z\xbc\xaf\x27\x1c", 6},
+    {"\xca\xfe\xba\xbe", 4},
+    {"\xcf\xfa\xed\xfe", 4},
+}};
+
+constexpr std::array<std::string_view, 35> BINARY_EXTENSIONS{{
+    "png", "jpg", "jpeg", "gif", "bmp", "ico", "webp", "tif", "tiff",
+    "zip", "gz", "tgz", "bz2", "xz", "zst", "7z", "rar", "jar",
+    "o", "a", "so", "dll", "exe", "dylib", "class", "pyc",
+    "mp3", "mp4", "mkv", "avi", "wav", "flac",
+    "woff", "woff2", "ttf",
+}};
+
+void appendUtf8(std::string& out, std::uint32_t cp){
+    if(cp < 0x80){
+        out.push_back(static_cast<char>(cp));
+    }else if(cp < 0x800){
+        out.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }else if(cp < 0x10000){
+        out.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }else{
+        out.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+}
+
+struct CachedKind{
+    std::int64_t mtime = 0;
+    std::uint64_t size = 0;
+    ContentKind kind = ContentKind::Text;
+};
+
+struct IdentityHash{
+    std::size_t operator()(const std::pair<std::uint64_t, std::uint64_t>& key) const{
+        return std::hash<std::uint64_t>{}(key.first * 0x9e3779b97f4a7c15ULL ^ key.second);
+    }
+};
+
+// Sharded by inode so scanner threads rarely wait on each other.
+struct KindCacheShard{
+    std::mutex mtx;
+    std::unordered_map<std::pair<std::uint64_t, std::uint64_t>, CachedKind, IdentityHash> entries;
+};
+
+constexpr std::size_t KIND_CACHE_SHARDS = 16;
+
+KindCacheShard& shardFor(const FileIdentity& identity){
+    static std::array<KindCacheShard, KIND_CACHE_SHARDS> shards;
+    return shards[identity.inode % KIND_CACHE_SHARDS];
+}
+
+}
+
+ContentKind classifyContent(std::string_view content){
+    const auto *data = reinterpret_cast<const unsigned char*>(content.data());
+    const std::size_t n = std::min(content.size(), BINARY_CHECK_BUFFER_SIZE);
+
+    if(n >= 2 && data[0] == 0xff && data[1] == 0xfe){
+        // FF FE 00 00 is the UTF-32 mark, which is not transcoded.
+        if(n >= 4 && data[2] == 0 && data[3] == 0) return ContentKind::Binary;
+        return ContentKind::Utf16LE;
+    }
+    if(n >= 2 && data[0] == 0xfe && data[1] == 0xff) return ContentKind::Utf16BE;
+
+    for(const Magic &magic : BINARY_MAGICS){
+        if(n >= magic.size && std::memcmp(data, magic.bytes, magic.size) == 0) return ContentKind::Binary;
+    }
+
+    SampleScan scan = scanSample(data, n);
+    if(scan.nul) return ContentKind::Binary;
+    std::size_t suspicious = scan.controls;
+    if(scan.highBytes) suspicious += invalidUtf8Bytes(data, n);
+    return suspicious * 8 > n ? ContentKind::Binary : ContentKind::Text;
+}
+
+bool isKnownBinaryName(std::string_view name){
+    std::size_t dot = name.rfind('.');
+    if(dot == std::string_view::npos || dot == 0 || name.size() - dot - 1 > 5) return false;
+
+    char ext[6];
+    std::size_t length = name.size() - dot - 1;
+    for(std::size_t i = 0; i < length; ++i){
+        char c = name[dot + 1 + i];
+        ext[i] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+    }
+    std::string_view lowered(ext, length);
+    return std::find(BINARY_EXTENSIONS.begin(), BINARY_EXTENSIONS.end(), lowered) != BINARY_EXTENSIONS.end();
+}
+
+std::string_view searchableText(std::string_view content, ContentKind kind){
+    if(kind != ContentKind::Utf16LE && kind != ContentKind::Utf16BE) return content;
+
+    thread_local std::string utf8;
+    utf8.clear();
+    utf8.reserve(content.size());
+    const auto *data = reinterpret_cast<const unsigned char*>(content.data());
+    const bool little = kind == ContentKind::Utf16LE;
+    auto unitAt = [&](std::size_t i) -> std::uint32_t {
+        return little ? (data[i] | (data[i + 1] << 8)) : ((data[i] << 8) | data[i + 1]);
+    };
+
+    // Skip the byte order mark; a trailing odd byte is dropped.
+    for(std::size_t i = 2; i + 1 < content.size(); i += 2){
+        std::uint32_t unit = unitAt(i);
+        if(unit >= 0xd800 && unit <= 0xdbff && i + 3 < content.size()){
+            std::uint32_t next = unitAt(i + 2);
+            if(next >= 0xdc00 && next <= 0xdfff){
+                appendUtf8(utf8, 0x10000 + ((unit - 0xd800) << 10) + (next - 0xdc00));
+                i += 2;
+                continue;
+            }
+        }
+        // Unpaired surrogates become U+FFFD.
+        appendUtf8(utf8, (unit >= 0xd800 && unit <= 0xdfff) ? 0xfffd : unit);
+    }
+    return utf8;
+}
+
+std::size_t utf16ByteLength(std::string_view utf8){
+    // Every code point is one UTF-16 unit, except those past U+FFFF (four
+    // UTF-8 bytes), which take a surrogate pair.
+    std::size_t units = 0;
+    for(char c : utf8){
+        auto byte = static_cast<unsigned char>(c);
+        if((byte & 0xc0) != 0x80) units += byte >= 0xf0 ? 2 : 1;
+    }
+    return units * 2;
+}
+
+bool cachedContentKind(const FileIdentity& identity, ContentKind& out){
+    if(identity.inode == 0) return false;
+    KindCacheShard &shard = shardFor(identity);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.entries.find({identity.device, identity.inode});
+    if(it == shard.entries.end() || it->second.mtime != identity.mtime || it->second.size != identity.size) return false;
+    out = it->second.kind;
+    return true;
+}
+
+void rememberContentKind(const FileIdentity& identity, ContentKind kind){
+    if(identity.inode == 0) return;
+    KindCacheShard &shard = shardFor(identity);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    if(shard.entries.size() >= CONTENT_CACHE_CAPACITY / KIND_CACHE_SHARDS) shard.entries.clear();
+    shard.entries[{identity.device, identity.inode}] = {identity.mtime, identity.size, kind};
+}
+
+bool isCachedBinary(const FileIdentity& identity){
+    ContentKind kind = ContentKind::Text;
+    return cachedContentKind(identity, kind) && kind == ContentKind::Binary;
+}
@@ -0,0 +1,888 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cctype>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "dfa_matcher.hpp"
+
+namespace{
+
+constexpr std::size_t MAX_NFA_STATES = 20000;
+constexpr std::size_t MAX_DFA_STATES = 4096;
+constexpr std::size_t MAX_CACHED_PROGRAMS = 32;
+
+using ByteSet = std::bitset<256>;
+
+struct Node{
+    enum class Kind{ Empty, Bytes, Concat, Alternate, Repeat, Begin, End };
+
+    Kind kind = Kind::Empty;
+    ByteSet bytes;
+    std::vector<Node> children;
+    int min = 0;
+    int max = -1;
+    // A lazy Repeat prefers fewer iterations when spans are extracted.
+    bool lazy = false;
+};
+
+class Parser{
+public:
+    Parser(std::string_view pattern, bool icase) : src(pattern), icase(icase) {}
+
+    RegexError parse(Node& out){
+        RegexError err = parseAlternate(out);
+        if(err != RegexError::Ok) return err;
+        if(pos != src.size()) return RegexError::UnsupportedSyntax;
+        return RegexError::Ok;
+    }
+
+private:
+    std::string_view src;
+    bool icase;
+    std::size_t pos = 0;
+    int depth = 0;
+
+    bool atEnd() const { return pos >= src.size(); }
+    char peek() const { return src[pos]; }
+
+    ByteSet literal(unsigned char c) const{
+        ByteSet set;
+        set.set(c);
+        if(icase && std::isalpha(c)){
+            set.set(static_cast<unsigned char>(std::tolower(c)));
+            set.set(static_cast<unsigned char>(std::toupper(c)));
+        }
+        return set;
+    }
+
+    void foldCase(ByteSet& set) const{
+        if(!icase) return;
+        for(int c = 'a'; c <= 'z'; ++c){
+            int upper = c - 'a' + 'A';
+            if(set.test(c) || set.test(upper)){
+                set.set(c);
+                set.set(upper);
+            }
+        }
+    }
+
+    static ByteSet classFor(char esc){
+        ByteSet set;
+        switch(esc){
+            case 'd': case 'D':
+                for(int c = '0'; c <= '9'; ++c) set.set(c);
+                break;
+            case 'w': case 'W':
+                for(int c = 0; c < 256; ++c){
+                    if(std::isalnum(c) || c == '_') set.set(c);
+                }
+                break;
+            case 's': case 'S':
+                for(char c : std::string_view(" \t\n\v\f\r")) set.set(static_cast<unsigned char>(c));
+                break;
+        }
+        if(std::isupper(static_cast<unsigned char>(esc))) set.flip();
+        return set;
+    }
+
+    static int hexValue(char c){
+        if(c >= '0' && c <= '9') return c - '0';
+        if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Parses the escape after a backslash into a set of bytes. `single` is
+    // set when the escape denotes exactly one byte (usable in class ranges).
+    RegexError parseEscape(ByteSet& out, int& single){
+        single = -1;
+        if(atEnd()) return RegexError::UnsupportedSyntax;
+        char c = src[pos++];
+        switch(c){
+            case 'd': case 'D': case 'w': case 'W': case 's': case 'S':
+                out = classFor(c);
+                return RegexError::Ok;
+            case 't': single = '\t'; break;
+            case 'n': single = '\n'; break;
+            case 'r': single = '\r'; break;
+            case 'f': single = '\f'; break;
+            case 'v': single = '\v'; break;
+            case 'x':{
+                if(pos + 2 > src.size()) return RegexError::UnsupportedSyntax;
+                int hi = hexValue(src[pos]);
+                int lo = hexValue(src[pos + 1]);
+                if(hi < 0 || lo < 0) return RegexError::UnsupportedSyntax;
+                pos += 2;
+                single = hi * 16 + lo;
+                break;
+                     }
+            default:
+                // Only escaped punctuation is a plain literal; letters and
+                // digits carry meaning (\b, \1, \u, \c...) we leave to std::regex.
+                if(std::isalnum(static_cast<unsigned char>(c))) return RegexError::UnsupportedSyntax;
+                single = static_cast<unsigned char>(c);
+                break;
+        }
+        out = literal(static_cast<unsigned char>(single));
+        return RegexError::Ok;
+    }
+
+    RegexError parseClass(Node& out){
+        ByteSet set;
+        bool negate = false;
+        if(!atEnd() && peek() == '^'){
+            negate = true;
+            ++pos;
+        }
+
+        bool first = true;
+        while(true){
+            if(atEnd()) return RegexError::UnsupportedSyntax;
+            char c = peek();
+            if(c == ']' && !first){
+                ++pos;
+                break;
+            }
+            if(c == ']' || c == '[') return RegexError::UnsupportedSyntax;
+            first = false;
+
+            int lo = -1;
+            ++pos;
+            if(c == '\\'){
+                if(!atEnd() && peek() == 'b') return RegexError::UnsupportedSyntax;
+                ByteSet escaped;
+                RegexError err = parseEscape(escaped, lo);
+                if(err != RegexError::Ok) return err;
+                if(lo < 0){
+                    set |= escaped;
+                    continue;
+                }
+            }else{
+                lo = static_cast<unsigned char>(c);
+            }
+
+            if(pos + 1 < src.size() && peek() == '-' && src[pos + 1] != ']'){
+                ++pos;
+                int hi = -1;
+                char h = src[pos++];
+                if(h == '\\'){
+                    ByteSet escaped;
+                    RegexError err = parseEscape(escaped, hi);
+                    if(err != RegexError::Ok) return err;
+                    if(hi < 0) return RegexError::UnsupportedSyntax;
+                }else{
+                    hi = static_cast<unsigned char>(h);
+                }
+                if(hi < lo) return RegexError::UnsupportedSyntax;
+                for(int b = lo; b <= hi; ++b) set.set(b);
+            }else{
+                set.set(lo);
+            }
+        }
+
+        foldCase(set);
+        if(negate) set.flip();
+        out.kind = Node::Kind::Bytes;
+        out.bytes = set;
+        return RegexError::Ok;
+    }
+
+    RegexError parseAtom(Node& out){
+        char c = src[pos++];
+        switch(c){
+            case '(':{
+                if(++depth > 200) return RegexError::UnsupportedSyntax;
+                if(!atEnd() && peek() == '?'){
+                    if(pos + 1 >= src.size() || src[pos + 1] != ':') return RegexError::UnsupportedSyntax;
+                    pos += 2;
+                }
+                RegexError err = parseAlternate(out);
+                if(err != RegexError::Ok) return err;
+                if(atEnd() || peek() != ')') return RegexError::UnsupportedSyntax;
+                ++pos;
+                --depth;
+                return RegexError::Ok;
+                     }
+            case '[':
+                return parseClass(out);
+            case '.':
+                out.kind = Node::Kind::Bytes;
+                out.bytes.set();
+                out.bytes.reset('\n');
+                out.bytes.reset('\r');
+                return RegexError::Ok;
+            case '^':
+                out.kind = Node::Kind::Begin;
+                return RegexError::Ok;
+            case '$':
+                out.kind = Node::Kind::End;
+                return RegexError::Ok;
+            case '\\':{
+                int single = -1;
+                out.kind = Node::Kind::Bytes;
+                return parseEscape(out.bytes, single);
+                      }
+            case ')': case '*': case '+': case '?': case '{': case '}': case ']':
+                return RegexError::UnsupportedSyntax;
+            default:
+                out.kind = Node::Kind::Bytes;
+                out.bytes = literal(static_cast<unsigned char>(c));
+                return RegexError::Ok;
+        }
+    }
+
+    bool parseBound(int& out){
+        std::size_t start = pos;
+        long value = 0;
+        while(!atEnd() && std::isdigit(static_cast<unsigned char>(peek()))){
+            value = value * 10 + (peek() - '0');
+            if(value > 1000) return false;
+            ++pos;
+        }
+        out = static_cast<int>(value);
+        return pos != start;
+    }
+
+    RegexError parseQuantifier(Node& atom, bool& applied){
+        applied = false;
+        if(atEnd()) return RegexError::Ok;
+
+        int min = 0;
+        int max = -1;
+        char c = peek();
+        if(c == '*'){
+            ++pos;
+        }else if(c == '+'){
+            min = 1;
+            ++pos;
+        }else if(c == '?'){
+            max = 1;
+            ++pos;
+        }else if(c == '{'){
+            ++pos;
+            if(!parseBound(min)) return RegexError::UnsupportedSyntax;
+            max = min;
+            if(!atEnd() && peek() == ','){
+                ++pos;
+                max = -1;
+                if(!atEnd() && peek() != '}' && !parseBound(max)) return RegexError::UnsupportedSyntax;
+            }
+            if(atEnd() || peek() != '}') return RegexError::UnsupportedSyntax;
+            ++pos;
+            if(max >= 0 && max < min) return RegexError::UnsupportedSyntax;
+        }else{
+            return RegexError::Ok;
+        }
+
+        // Lazy quantifiers accept the same lines; they only change which
+        // span priorityMatchEnd picks.
+        bool lazy = false;
+        if(!atEnd() && peek() == '?'){
+            lazy = true;
+            ++pos;
+        }
+
+        if(atom.kind == Node::Kind::Begin || atom.kind == Node::Kind::End) return RegexError::UnsupportedSyntax;
+
+        Node repeat;
+        repeat.kind = Node::Kind::Repeat;
+        repeat.min = min;
+        repeat.max = max;
+        repeat.lazy = lazy;
+        repeat.children.push_back(std::move(atom));
+        atom = std::move(repeat);
+        applied = true;
+        return RegexError::Ok;
+    }
+
+    RegexError parseConcat(Node& out){
+        out.kind = Node::Kind::Concat;
+        while(!atEnd() && peek() != '|' && peek() != ')'){
+            Node atom;
+            RegexError err = parseAtom(atom);
+            if(err != RegexError::Ok) return err;
+
+            bool applied = false;
+            err = parseQuantifier(atom, applied);
+            if(err != RegexError::Ok) return err;
+            if(applied && !atEnd() && (peek() == '*' || peek() == '+' || peek() == '?' || peek() == '{')){
+                return RegexError::UnsupportedSyntax;
+            }
+            out.children.push_back(std::move(atom));
+        }
+        return RegexError::Ok;
+    }
+
+    RegexError parseAlternate(Node& out){
+        Node first;
+        RegexError err = parseConcat(first);
+        if(err != RegexError::Ok) return err;
+        if(atEnd() || peek() != '|'){
+            out = std::move(first);
+            return RegexError::Ok;
+        }
+
+        out.kind = Node::Kind::Alternate;
+        out.children.push_back(std::move(first));
+        while(!atEnd() && peek() == '|'){
+            ++pos;
+            Node branch;
+            err = parseConcat(branch);
+            if(err != RegexError::Ok) return err;
+            out.children.push_back(std::move(branch));
+        }
+        return RegexError::Ok;
+    }
+};
+
+// Returns the byte a set stands for when it is one character (or one letter
+// in both cases), or -1. Newlines never qualify: matching is per line.
+int singleByte(const ByteSet& set){
+    std::size_t count = set.count();
+    if(count == 0 || count > 2) return -1;
+    int first = -1;
+    for(int b = 0; b < 256; ++b){
+        if(!set.test(b)) continue;
+        if(first < 0){
+            first = b;
+        }else if(!(std::isalpha(first) && std::tolower(first) == std::tolower(b))){
+            return -1;
+        }
+    }
+    if(first == '\n') return -1;
+    return std::tolower(first);
+}
+
+void keepRun(std::vector<std::string>& runs, std::string& run){
+    if(!run.empty()) runs.push_back(std::move(run));
+    run.clear();
+}
+
+// Runs of single characters that every match of `node` contains.
+void collectRequired(const Node& node, std::vector<std::string>& runs){
+    switch(node.kind){
+        case Node::Kind::Bytes:{
+            int c = singleByte(node.bytes);
+            if(c >= 0) runs.emplace_back(1, static_cast<char>(c));
+            break;
+                               }
+        case Node::Kind::Concat:{
+            std::string run;
+            for(const auto &child : node.children){
+                int c = child.kind == Node::Kind::Bytes ? singleByte(child.bytes) : -1;
+                if(c >= 0){
+                    run.push_back(static_cast<char>(c));
+                    continue;
+                }
+                keepRun(runs, run);
+                collectRequired(child, runs);
+            }
+            keepRun(runs, run);
+            break;
+                                }
+        case Node::Kind::Repeat:
+            if(node.min >= 1) collectRequired(node.children.front(), runs);
+            break;
+        default:
+            break;
+    }
+}
+
+bool isPureLiteral(const Node& node, bool icase){
+    auto literalByte = [icase](const Node& n){
+        if(n.kind != Node::Kind::Bytes) return false;
+        int c = singleByte(n.bytes);
+        if(c < 0) return false;
+        return icase || !std::isalpha(c);
+    };
+    if(node.kind == Node::Kind::Bytes) return literalByte(node);
+    if(node.kind != Node::Kind::Concat || node.children.empty()) return false;
+    for(const auto &child : node.children){
+        if(!literalByte(child)) return false;
+    }
+    return true;
+}
+
+// A Split prefers `out` over `out1`, the order a backtracking engine would
+// try them in. The DFA ignores the order; priorityMatch follows it.
+struct NfaState{
+    enum class Kind : std::uint8_t{ Bytes, Split, Epsilon, Begin, End, Match };
+
+    Kind kind = Kind::Epsilon;
+    int out = -1;
+    int out1 = -1;
+    int set = -1;
+};
+
+struct Program{
+    std::vector<NfaState> states;
+    std::vector<ByteSet> sets;
+    std::array<std::uint8_t, 256> byteClass{};
+    int classCount = 0;
+    int start = -1;
+    std::uint64_t id = 0;
+};
+
+class NfaBuilder{
+public:
+    explicit NfaBuilder(Program& prog) : prog(prog) {}
+
+    bool build(const Node& root){
+        int match = add(NfaState::Kind::Match);
+        prog.start = compile(root, match);
+        return prog.start >= 0;
+    }
+
+private:
+    Program& prog;
+
+    int add(NfaState::Kind kind, int out = -1, int out1 = -1){
+        if(prog.states.size() >= MAX_NFA_STATES) return -1;
+        NfaState st;
+        st.kind = kind;
+        st.out = out;
+        st.out1 = out1;
+        prog.states.push_back(st);
+        return static_cast<int>(prog.states.size() - 1);
+    }
+
+    // Split that prefers `first`, or `second` for a lazy repeat.
+    int choice(int first, int second, bool lazy){
+        return lazy ? add(NfaState::Kind::Split, second, first) : add(NfaState::Kind::Split, first, second);
+    }
+
+    int star(const Node& node, int next, bool lazy){
+        int split = add(NfaState::Kind::Split);
+        if(split < 0) return -1;
+        int body = compile(node, split);
+        if(body < 0) return -1;
+        prog.states[split].out = lazy ? next : body;
+        prog.states[split].out1 = lazy ? body : next;
+        return split;
+    }
+
+    int compile(const Node& node, int next){
+        if(next < 0) return -1;
+        switch(node.kind){
+            case Node::Kind::Empty:
+                return next;
+            case Node::Kind::Bytes:{
+                int st = add(NfaState::Kind::Bytes, next);
+                if(st < 0) return -1;
+                prog.states[st].set = static_cast<int>(prog.sets.size());
+                prog.sets.push_back(node.bytes);
+                return st;
+                                   }
+            case Node::Kind::Begin:
+                return add(NfaState::Kind::Begin, next);
+            case Node::Kind::End:
+                return add(NfaState::Kind::End, next);
+            case Node::Kind::Concat:{
+                int entry = next;
+                for(auto it = node.children.rbegin(); it != node.children.rend() && entry >= 0; ++it){
+                    entry = compile(*it, entry);
+                }
+                return entry;
+                                    }
+            case Node::Kind::Alternate:{
+                int entry = compile(node.children.back(), next);
+                for(std::size_t i = node.children.size() - 1; i-- > 0 && entry >= 0;){
+                    int branch = compile(node.children[i], next);
+                    if(branch < 0) return -1;
+                    entry = add(NfaState::Kind::Split, branch, entry);
+                }
+                return entry;
+                                       }
+            case Node::Kind::Repeat:{
+                const Node& body = node.children.front();
+                int tail = next;
+                if(node.max < 0){
+                    tail = star(body, tail, node.lazy);
+                }else{
+                    for(int i = node.min; i < node.max && tail >= 0; ++i){
+                        int entry = compile(body, tail);
+                        if(entry < 0) return -1;
+                        tail = choice(entry, tail, node.lazy);
+                    }
+                }
+                for(int i = 0; i < node.min && tail >= 0; ++i){
+                    tail = compile(body, tail);
+                }
+                return tail;
+                                    }
+        }
+        return -1;
+    }
+};
+
+void computeByteClasses(Program& prog){
+    // Bytes that every set treats identically share one transition column.
+    std::vector<std::vector<bool>> signatures;
+    for(int b = 0; b < 256; ++b){
+        std::vector<bool> sig;
+        sig.reserve(prog.sets.size());
+        for(const auto &set : prog.sets) sig.push_back(set.test(b));
+
+        int cls = -1;
+        for(std::size_t i = 0; i < signatures.size(); ++i){
+            if(signatures[i] == sig){
+                cls = static_cast<int>(i);
+                break;
+            }
+        }
+        if(cls < 0){
+            cls = static_cast<int>(signatures.size());
+            signatures.push_back(std::move(sig));
+        }
+        prog.byteClass[b] = static_cast<std::uint8_t>(cls);
+    }
+    prog.classCount = static_cast<int>(signatures.size());
+}
+
+// Lazily built DFA for one program. Not thread-safe: every scanner thread
+// owns its own cache (see cacheFor).
+class DfaCache{
+public:
+    explicit DfaCache(const Program& prog) : prog(prog), mark(prog.states.size(), 0) {}
+
+    int startState(bool atTextBegin){
+        int &slot = startIndex[atTextBegin ? 1 : 0];
+        if(slot < 0){
+            std::vector<int> set;
+            addClosure(set, prog.start, atTextBegin);
+            slot = intern(set, atTextBegin);
+        }
+        return slot;
+    }
+
+    int next(int state, unsigned char byte){
+        int n = trans[static_cast<std::size_t>(state) * prog.classCount + prog.byteClass[byte]];
+        if(n >= 0) return n;
+        return computeNext(state, byte);
+    }
+
+    bool isMatch(int state) const { return info[state].match; }
+    bool isDead(int state) const { return info[state].dead; }
+    bool acceptsAtEnd(int state) const { return info[state].endAccept; }
+
+private:
+    struct StateInfo{
+        bool match = false;
+        bool endAccept = false;
+        bool dead = false;
+    };
+
+    const Program& prog;
+    std::vector<std::vector<int>> sets;
+    std::vector<StateInfo> info;
+    std::vector<int> trans;
+    std::unordered_map<std::string, int> index;
+    std::array<int, 2> startIndex{-1, -1};
+    std::vector<std::uint32_t> mark;
+    std::uint32_t generation = 0;
+    std::vector<int> stack;
+
+    void addClosure(std::vector<int>& set, int from, bool atTextBegin){
+        if(++generation == 0){
+            std::fill(mark.begin(), mark.end(), 0);
+            generation = 1;
+        }
+        stack.clear();
+        stack.push_back(from);
+        while(!stack.empty()){
+            int s = stack.back();
+            stack.pop_back();
+            if(s < 0 || mark[s] == generation) continue;
+            mark[s] = generation;
+
+            const NfaState &st = prog.states[s];
+            switch(st.kind){
+                case NfaState::Kind::Bytes:
+                case NfaState::Kind::Match:
+                case NfaState::Kind::End:
+                    set.push_back(s);
+                    break;
+                case NfaState::Kind::Split:
+                    stack.push_back(st.out1);
+                    stack.push_back(st.out);
+                    break;
+                case NfaState::Kind::Epsilon:
+                    stack.push_back(st.out);
+                    break;
+                case NfaState::Kind::Begin:
+                    if(atTextBegin) stack.push_back(st.out);
+                    break;
+            }
+        }
+    }
+
+    bool reachesMatchAtEnd(const std::vector<int>& set, bool atTextBegin) const{
+        std::vector<char> seen(prog.states.size(), 0);
+        std::vector<int> work(set.begin(), set.end());
+        while(!work.empty()){
+            int s = work.back();
+            work.pop_back();
+            if(s < 0 || seen[s]) continue;
+            seen[s] = 1;
+            const NfaState &st = prog.states[s];
+            switch(st.kind){
+                case NfaState::Kind::Match:
+                    return true;
+                case NfaState::Kind::End:
+                case NfaState::Kind::Epsilon:
+                    work.push_back(st.out);
+                    break;
+                case NfaState::Kind::Split:
+                    work.push_back(st.out);
+                    work.push_back(st.out1);
+                    break;
+                case NfaState::Kind::Begin:
+                    if(atTextBegin) work.push_back(st.out);
+                    break;
+                case NfaState::Kind::Bytes:
+                    break;
+            }
+        }
+        return false;
+    }
+
+    int intern(std::vector<int>& set, bool atTextBegin){
+        std::sort(set.begin(), set.end());
+        set.erase(std::unique(set.begin(), set.end()), set.end());
+
+        std::string key(reinterpret_cast<const char*>(set.data()), set.size() * sizeof(int));
+        key.push_back(atTextBegin ? '\1' : '\0');
+        auto found = index.find(key);
+        if(found != index.end()) return found->second;
+
+        StateInfo si;
+        for(int s : set){
+            if(prog.states[s].kind == NfaState::Kind::Match) si.match = true;
+        }
+        si.endAccept = si.match || reachesMatchAtEnd(set, atTextBegin);
+        si.dead = set.empty();
+
+        int id = static_cast<int>(sets.size());
+        sets.push_back(set);
+        info.push_back(si);
+        trans.resize(trans.size() + prog.classCount, -1);
+        index.emplace(std::move(key), id);
+        return id;
+    }
+
+    void flush(){
+        sets.clear();
+        info.clear();
+        trans.clear();
+        index.clear();
+        startIndex = {-1, -1};
+    }
+
+    int computeNext(int state, unsigned char byte){
+        std::vector<int> next;
+        for(int s : sets[state]){
+            const NfaState &st = prog.states[s];
+            if(st.kind == NfaState::Kind::Bytes && prog.sets[st.set].test(byte)){
+                addClosureInto(next, st.out);
+            }
+        }
+        // Unanchored: a match may start at any byte.
+        addClosureInto(next, prog.start);
+
+        if(sets.size() >= MAX_DFA_STATES){
+            flush();
+            return intern(next, false);
+        }
+        int id = intern(next, false);
+        trans[static_cast<std::size_t>(state) * prog.classCount + prog.byteClass[byte]] = id;
+        return id;
+    }
+
+    void addClosureInto(std::vector<int>& set, int from){
+        std::vector<int> part;
+        addClosure(part, from, false);
+        set.insert(set.end(), part.begin(), part.end());
+    }
+};
+
+// Leftmost match at or after `from` as a backtracking engine such as
+// std::regex reports it: leftmost-first rather than longest. A Pike VM runs
+// the NFA threads in lockstep in priority order, one pass over the text. A
+// thread started at an earlier offset outranks one started later, so new
+// starts are seeded last and stop once a match is found. When a thread
+// matches, every lower-priority thread is dropped.
+bool priorityMatch(const Program& prog, std::string_view text, std::size_t from, MatchSpan& span){
+    struct Thread{
+        int state;
+        std::size_t start;
+    };
+    struct Scratch{
+        std::vector<Thread> current, next;
+        std::vector<int> stack;
+        std::vector<std::uint32_t> mark;
+        std::uint32_t generation = 0;
+    };
+    thread_local Scratch scratch;
+    if(scratch.mark.size() < prog.states.size()){
+        scratch.mark.assign(prog.states.size(), 0);
+        scratch.generation = 0;
+    }
+
+    // Appends the Bytes states reachable from `from` at `pos` in priority
+    // order. Returns true, and adds nothing past that point, on reaching Match.
+    auto addClosure = [&](std::vector<Thread>& list, int state, std::size_t start, std::size_t pos){
+        std::vector<int> &stack = scratch.stack;
+        stack.clear();
+        stack.push_back(state);
+        while(!stack.empty()){
+            int s = stack.back();
+            stack.pop_back();
+            if(s < 0 || scratch.mark[s] == scratch.generation) continue;
+            scratch.mark[s] = scratch.generation;
+
+            const NfaState &st = prog.states[s];
+            switch(st.kind){
+                case NfaState::Kind::Bytes:
+                    list.push_back({s, start});
+                    break;
+                case NfaState::Kind::Match:
+                    return true;
+                case NfaState::Kind::Split:
+                    stack.push_back(st.out1);
+                    stack.push_back(st.out);
+                    break;
+                case NfaState::Kind::Epsilon:
+                    stack.push_back(st.out);
+                    break;
+                case NfaState::Kind::Begin:
+                    if(pos == 0) stack.push_back(st.out);
+                    break;
+                case NfaState::Kind::End:
+                    if(pos == text.size()) stack.push_back(st.out);
+                    break;
+            }
+        }
+        return false;
+    };
+    auto nextGeneration = [&]{
+        if(++scratch.generation == 0){
+            std::fill(scratch.mark.begin(), scratch.mark.end(), 0);
+            scratch.generation = 1;
+        }
+    };
+
+    bool matched = false;
+    std::vector<Thread> &current = scratch.current;
+    std::vector<Thread> &next = scratch.next;
+    current.clear();
+    nextGeneration();
+    for(std::size_t pos = from; ; ++pos){
+        // The seed shares this position's generation, so a state already
+        // held by an earlier start is not taken over by this one.
+        if(!matched && addClosure(current, prog.start, pos, pos)){
+            matched = true;
+            span = {pos, pos};
+        }
+        if(pos == text.size() || (matched && current.empty())) break;
+
+        unsigned char byte = static_cast<unsigned char>(text[pos]);
+        next.clear();
+        nextGeneration();
+        for(const Thread &thread : current){
+            const NfaState &st = prog.states[thread.state];
+            if(!prog.sets[st.set].test(byte)) continue;
+            if(addClosure(next, st.out, thread.start, pos + 1)){
+                matched = true;
+                span = {thread.start, pos + 1};
+                break;
+            }
+        }
+        current.swap(next);
+    }
+    return matched;
+}
+
+std::atomic<std::uint64_t> nextProgramId{1};
+
+DfaCache& cacheFor(const std::shared_ptr<const Program>& prog){
+    struct Entry{
+        std::shared_ptr<const Program> prog;
+        std::unique_ptr<DfaCache> cache;
+    };
+    thread_local std::unordered_map<std::uint64_t, Entry> caches;
+
+    auto it = caches.find(prog->id);
+    if(it == caches.end()){
+        if(caches.size() >= MAX_CACHED_PROGRAMS) caches.clear();
+        it = caches.emplace(prog->id, Entry{prog, {}}).first;
+    }
+    auto &slot = it->second.cache;
+    if(!slot) slot = std::make_unique<DfaCache>(*prog);
+    return *slot;
+}
+
+class DfaMatcher : public Matcher{
+public:
+    explicit DfaMatcher(std::shared_ptr<const Program> prog) : prog(std::move(prog)) {}
+
+    bool search(std::string_view text) const override{
+        return firstMatchEnd(text, 0) != std::string_view::npos;
+    }
+
+    bool find(std::string_view text, std::size_t from, MatchSpan& span) const override{
+        // The DFA rejects lines without a match; only a line that has one
+        // pays for the NFA pass that pins down std::regex's span.
+        if(firstMatchEnd(text, from) == std::string_view::npos) return false;
+        return priorityMatch(*prog, text, from, span);
+    }
+
+    const char* engineName() const override { return "lazy-dfa"; }
+
+private:
+    std::shared_ptr<const Program> prog;
+
+    std::size_t firstMatchEnd(std::string_view text, std::size_t from) const{
+        DfaCache &dfa = cacheFor(prog);
+        int state = dfa.startState(from == 0);
+        if(dfa.isMatch(state)) return from;
+        for(std::size_t i = from; i < text.size(); ++i){
+            state = dfa.next(state, static_cast<unsigned char>(text[i]));
+            if(dfa.isMatch(state)) return i + 1;
+        }
+        if(dfa.acceptsAtEnd(state)) return text.size();
+        return std::string_view::npos;
+    }
+};
+
+}
+
+std::pair<MatcherPtr, RegexError> compileDfaMatcher(const std::string& pattern, bool icase){
+    Node root;
+    Parser parser(pattern, icase);
+    RegexError err = parser.parse(root);
+    if(err != RegexError::Ok) return {nullptr, err};
+
+    auto prog = std::make_shared<Program>();
+    NfaBuilder builder(*prog);
+    if(!builder.build(root)) return {nullptr, RegexError::UnsupportedSyntax};
+    computeByteClasses(*prog);
+    prog->id = nextProgramId.fetch_add(1, std::memory_order_relaxed);
+
+    LiteralInfo literals;
+    collectRequired(root, literals.required);
+    std::string longest;
+    for(const auto &run : literals.required){
+        if(run.size() > longest.size()) longest = run;
+    }
+    literals.finder = LiteralFinder(longest);
+    literals.pure = !longest.empty() && isPureLiteral(root, icase);
+
+    auto matcher = std::make_shared<DfaMatcher>(std::move(prog));
+    matcher->setLiteralInfo(std::move(literals));
+    return {matcher, RegexError::Ok};
+}
@@ -0,0 +1,282 @@
+#include <cerrno>
+#include <vector>
+#include "config.hpp"
+#include "dir_walker.hpp"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace{
+
+FileError dirErrnoToFileError(int err){
+    if(err == EACCES || err == EPERM) return FileError::PermissionDenied;
+    if(err == ENOENT) return FileError::PathNotFound;
+    if(err == ENOTDIR) return FileError::NotADirectory;
+    return FileError::UnknownError;
+}
+
+#ifdef __linux__
+// Record layout returned by getdents64; glibc does not export it.
+struct LinuxDirent64{
+    std::uint64_t d_ino;
+    std::int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+struct RawEntry{
+    std::uint32_t nameOffset;
+    std::uint32_t nameLength;
+    EntryType type;
+};
+
+// All entries of one open directory. Names live back to back in `names`.
+struct DirListing{
+    std::string names;
+    std::vector<RawEntry> entries;
+
+    std::string_view name(const RawEntry& entry) const{
+        return std::string_view(names).substr(entry.nameOffset, entry.nameLength);
+    }
+    void clear(){
+        names.clear();
+        entries.clear();
+    }
+};
+
+std::vector<char>& direntBuffer(){
+    thread_local std::vector<char> buffer(DIR_READ_BUFFER_SIZE);
+    return buffer;
+}
+
+EntryType typeFromMode(mode_t mode){
+    if(S_ISREG(mode)) return EntryType::File;
+    if(S_ISDIR(mode)) return EntryType::Directory;
+    if(S_ISLNK(mode)) return EntryType::Symlink;
+    return EntryType::Other;
+}
+
+EntryType typeFromDirent(int dirFd, const char* name, unsigned char kind){
+    switch(kind){
+        case DT_REG: return EntryType::File;
+        case DT_DIR: return EntryType::Directory;
+        case DT_LNK: return EntryType::Symlink;
+        case DT_UNKNOWN:{
+            // Some filesystems leave d_type empty; only those entries pay for a stat.
+            struct stat st;
+            if(fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) return EntryType::Other;
+            return typeFromMode(st.st_mode);
+        }
+        default: return EntryType::Other;
+    }
+}
+
+bool readListing(int dirFd, DirListing& out){
+    std::vector<char> &buffer = direntBuffer();
+    while(true){
+        long n = syscall(SYS_getdents64, dirFd, buffer.data(), buffer.size());
+        if(n < 0){
+            if(errno == EINTR) continue;
+            return false;
+        }
+        if(n == 0) return true;
+
+        for(long pos = 0; pos < n;){
+            const LinuxDirent64 *entry = reinterpret_cast<const LinuxDirent64*>(buffer.data() + pos);
+            pos += entry->d_reclen;
+
+            const char *name = entry->d_name;
+            if(name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+            std::string_view view(name);
+            out.entries.push_back({static_cast<std::uint32_t>(out.names.size()), static_cast<std::uint32_t>(view.size()),
+                                   typeFromDirent(dirFd, name, entry->d_type)});
+            out.names.append(view.data(), view.size());
+        }
+    }
+}
+
+struct WalkFrame{
+    int fd = -1;
+    std::size_t pathLength = 0;
+    std::size_t next = 0;
+    DirListing listing;
+};
+#endif
+
+}
+
+std::string joinPath(const std::string& dir, std::string_view name){
+    std::string out;
+    out.reserve(dir.size() + name.size() + 1);
+    out = dir;
+    if(!out.empty() && out.back() != '/') out += '/';
+    out.append(name.data(), name.size());
+    return out;
+}
+
+std::string WalkEntry::path() const{
+    return joinPath(*dirPath, entryName);
+}
+
+std::string_view WalkEntry::path(Arena& arena) const{
+    return arena.joinPath(*dirPath, entryName);
+}
+
+#ifdef __linux__
+bool WalkEntry::isRegularFile() const{
+    if(entryType == EntryType::File) return true;
+    if(entryType != EntryType::Symlink) return false;
+
+    std::string name(entryName);
+    struct stat st;
+    return fstatat(dirFd, name.c_str(), &st, 0) == 0 && S_ISREG(st.st_mode);
+}
+
+FileError walkTree(const std::filesystem::path& root, const std::function<WalkAction(const WalkEntry&)>& visit){
+    int rootFd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(rootFd < 0) return dirErrnoToFileError(errno);
+
+    // Frames are reused across directories so their listings keep their
+    // capacity; `depth` is the number of frames in use.
+    std::vector<WalkFrame> frames(1);
+    std::size_t depth = 1;
+    std::string dirPath = root.string();
+
+    frames[0].fd = rootFd;
+    frames[0].pathLength = dirPath.size();
+    if(!readListing(rootFd, frames[0].listing)){
+        int err = errno;
+        close(rootFd);
+        return dirErrnoToFileError(err);
+    }
+
+    WalkEntry entry;
+    entry.dirPath = &dirPath;
+    bool stopped = false;
+
+    while(depth > 0 && !stopped){
+        WalkFrame &frame = frames[depth - 1];
+        if(frame.next == frame.listing.entries.size()){
+            close(frame.fd);
+            frame.fd = -1;
+            frame.next = 0;
+            frame.listing.clear();
+            --depth;
+            if(depth > 0) dirPath.resize(frames[depth - 1].pathLength);
+            continue;
+        }
+
+        const RawEntry raw = frame.listing.entries[frame.next++];
+        entry.dirFd = frame.fd;
+        entry.entryName = frame.listing.name(raw);
+        entry.entryType = raw.type;
+        entry.entryDepth = static_cast<int>(depth - 1);
+
+        WalkAction action = visit(entry);
+        if(action == WalkAction::Stop){
+            stopped = true;
+            break;
+        }
+        if(raw.type != EntryType::Directory || action == WalkAction::SkipChildren) continue;
+
+        std::string name(entry.entryName);
+        int childFd = openat(frame.fd, name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if(childFd < 0) continue;
+
+        if(frames.size() == depth) frames.emplace_back();
+        WalkFrame &child = frames[depth];
+        if(!readListing(childFd, child.listing)){
+            close(childFd);
+            child.listing.clear();
+            continue;
+        }
+        dirPath = joinPath(dirPath, name);
+        child.fd = childFd;
+        child.pathLength = dirPath.size();
+        child.next = 0;
+        ++depth;
+    }
+
+    for(std::size_t i = 0; i < depth; ++i) close(frames[i].fd);
+    return FileError::Ok;
+}
+
+FileError listDirectory(const std::string& path, const std::function<void(std::string_view, EntryType)>& emit){
+    int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd < 0) return dirErrnoToFileError(errno);
+
+    DirListing listing;
+    bool ok = readListing(fd, listing);
+    int err = errno;
+    close(fd);
+    if(!ok) return dirErrnoToFileError(err);
+
+    for(const auto &raw : listing.entries) emit(listing.name(raw), raw.type);
+    return FileError::Ok;
+}
+#else
+namespace{
+
+EntryType typeFromStatus(const std::filesystem::file_status& status){
+    if(std::filesystem::is_symlink(status)) return EntryType::Symlink;
+    if(std::filesystem::is_regular_file(status)) return EntryType::File;
+    if(std::filesystem::is_directory(status)) return EntryType::Directory;
+    return EntryType::Other;
+}
+
+}
+
+bool WalkEntry::isRegularFile() const{
+    if(entryType == EntryType::File) return true;
+    if(entryType != EntryType::Symlink) return false;
+    std::error_code ec;
+    return std::filesystem::is_regular_file(path(), ec);
+}
+
+FileError walkTree(const std::filesystem::path& root, const std::function<WalkAction(const WalkEntry&)>& visit){
+    std::error_code ec;
+    std::filesystem::recursive_directory_iterator it(root, std::filesystem::directory_options::skip_permission_denied, ec);
+    if(ec) return dirErrnoToFileError(ec.value());
+
+    WalkEntry entry;
+    std::string dirPath;
+    std::string name;
+    entry.dirPath = &dirPath;
+    for(; it != std::filesystem::recursive_directory_iterator(); it.increment(ec)){
+        if(ec){
+            ec.clear();
+            continue;
+        }
+        dirPath = it->path().parent_path().string();
+        name = it->path().filename().string();
+        entry.entryName = name;
+        entry.entryType = typeFromStatus(it->symlink_status(ec));
+        entry.entryDepth = it.depth();
+
+        WalkAction action = visit(entry);
+        if(action == WalkAction::Stop) break;
+        if(action == WalkAction::SkipChildren) it.disable_recursion_pending();
+    }
+    return FileError::Ok;
+}
+
+FileError listDirectory(const std::string& path, const std::function<void(std::string_view, EntryType)>& emit){
+    std::error_code ec;
+    std::filesystem::directory_iterator it(path, ec);
+    if(ec) return dirErrnoToFileError(ec.value());
+    for(; it != std::filesystem::directory_iterator(); it.increment(ec)){
+        if(ec) break;
+        std::error_code stat_ec;
+        std::string name = it->path().filename().string();
+        emit(name, typeFromStatus(it->symlink_status(stat_ec)));
+    }
+    return FileError::Ok;
+}
+#endif
@@ -63,6 +63,15 @@ void matchFileError(FileError err){
         case FileError::NotADirectory:
             std::cerr << "[ERROR] The specified path is not a directory.\n";
             break;
+        case FileError::NotSupported:
+            std::cerr << "[ERROR] Operation not supported on this platform.\n";
+            break;
+        case FileError::FileTooLarge:
+            std::cerr << "[ERROR] File exceeds the size limit.\n";
+            break;
+        case FileError::Skipped:
+            std::cerr << "[ERROR] File was skipped.\n";
+            break;
          case FileError::UnknownError:
             std::cerr << "[ERROR] Unknown error.\n";
             break;           
@@ -96,6 +105,12 @@ void matchRegexError(RegexError err){
             break;
         case RegexError::InternalRegexError:
             break;
+        case RegexError::IndexUnavailable:
+            std::cerr << "[ERROR] No usable search index. Run 'index build' first.\n";
+            break;
+        case RegexError::UnsupportedSyntax:
+            std::cerr << "[ERROR] Pattern uses unsupported regex syntax.\n";
+            break;
     }
 }
 
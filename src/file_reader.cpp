@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <vector>
+#include "config.hpp"
+#include "file_reader.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FILE_READER_POSIX 1
+#endif
+
+namespace{
+
+std::vector<char>& threadBuffer(){
+    thread_local std::vector<char> buffer;
+    return buffer;
+}
+
+FileError errnoToFileError(int err){
+    if(err == EACCES || err == EPERM) return FileError::PermissionDenied;
+    if(err == ENOENT) return FileError::FileNotFound;
+    return FileError::OpenFailure;
+}
+
+}
+
+FileBuffer::~FileBuffer(){
+    release();
+}
+
+FileBuffer::FileBuffer(FileBuffer&& other) noexcept : data(other.data), size(other.size), mapped(other.mapped), fileIdentity(other.fileIdentity){
+    other.data = nullptr;
+    other.size = 0;
+    other.mapped = false;
+}
+
+FileBuffer& FileBuffer::operator=(FileBuffer&& other) noexcept{
+    if(this != &other){
+        release();
+        data = other.data;
+        size = other.size;
+        mapped = other.mapped;
+        fileIdentity = other.fileIdentity;
+        other.data = nullptr;
+        other.size = 0;
+        other.mapped = false;
+    }
+    return *this;
+}
+
+void FileBuffer::release(){
+#ifdef FILE_READER_POSIX
+    if(mapped && data) munmap(const_cast<char*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+    mapped = false;
+}
+
+#ifdef FILE_READER_POSIX
+bool statIdentity(int fd, FileIdentity& out){
+    struct stat st;
+    if(fstat(fd, &st) != 0) return false;
+    out.device = static_cast<std::uint64_t>(st.st_dev);
+    out.inode = static_cast<std::uint64_t>(st.st_ino);
+#ifdef __APPLE__
+    out.mtime = static_cast<std::int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    out.mtime = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    out.size = static_cast<std::uint64_t>(st.st_size);
+    return true;
+}
+
+std::pair<FileBuffer, FileError> readWholeFile(const char* path, std::size_t maxSize, bool (*skip)(const FileIdentity&)){
+    FileBuffer buffer;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return {std::move(buffer), errnoToFileError(errno)};
+
+    if(!statIdentity(fd, buffer.fileIdentity)){
+        int err = errno;
+        close(fd);
+        return {std::move(buffer), errnoToFileError(err)};
+    }
+    std::size_t fileSize = static_cast<std::size_t>(buffer.fileIdentity.size);
+    if(fileSize > maxSize){
+        close(fd);
+        return {std::move(buffer), FileError::FileTooLarge};
+    }
+    if(skip && skip(buffer.fileIdentity)){
+        close(fd);
+        return {std::move(buffer), FileError::Skipped};
+    }
+
+    if(fileSize >= MMAP_THRESHOLD){
+        void *addr = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(addr == MAP_FAILED) return {std::move(buffer), FileError::ReadFailure};
+        madvise(addr, fileSize, MADV_SEQUENTIAL);
+        buffer.data = static_cast<const char*>(addr);
+        buffer.size = fileSize;
+        buffer.mapped = true;
+        return {std::move(buffer), FileError::Ok};
+    }
+
+    std::vector<char> &owned = threadBuffer();
+    if(owned.size() < fileSize) owned.resize(std::max(fileSize, READ_BUFFER_SIZE));
+
+    std::size_t total = 0;
+    while(total < fileSize){
+        ssize_t n = pread(fd, owned.data() + total, fileSize - total, static_cast<off_t>(total));
+        if(n < 0){
+            if(errno == EINTR) continue;
+            close(fd);
+            return {std::move(buffer), FileError::ReadFailure};
+        }
+        if(n == 0) break;
+        total += static_cast<std::size_t>(n);
+    }
+    close(fd);
+
+    buffer.data = owned.data();
+    buffer.size = total;
+    return {std::move(buffer), FileError::Ok};
+}
+#else
+bool statIdentity(int, FileIdentity& out){
+    out = FileIdentity();
+    return false;
+}
+
+std::pair<FileBuffer, FileError> readWholeFile(const char* path, std::size_t maxSize, bool (*skip)(const FileIdentity&)){
+    FileBuffer buffer;
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if(!in) return {std::move(buffer), errnoToFileError(errno)};
+
+    std::size_t fileSize = static_cast<std::size_t>(in.tellg());
+    if(fileSize > maxSize) return {std::move(buffer), FileError::FileTooLarge};
+    (void)skip;
+    in.seekg(0);
+
+    std::vector<char> &owned = threadBuffer();
+    if(owned.size() < fileSize) owned.resize(std::max(fileSize, READ_BUFFER_SIZE));
+    in.read(owned.data(), static_cast<std::streamsize>(fileSize));
+
+    buffer.data = owned.data();
+    buffer.size = static_cast<std::size_t>(in.gcount());
+    return {std::move(buffer), FileError::Ok};
+}
+#endif
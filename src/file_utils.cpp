@@ -1,8 +1,14 @@
+#include <cerrno>
+#include <cstdio>
 #include <iostream>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <filesystem>
 #include "errors.hpp"
+#include "index_watcher.hpp"
+#include "output_sink.hpp"
+#include "tree_snapshot.hpp"
 
 [[nodiscard]]
 FileError checkFile(const std::string &filename){
@@ -15,35 +21,32 @@ FileError checkFile(const std::string &filename){
 [[nodiscard]]
 FileError createFile(const std::string &filename){
     if(filename.empty()) return FileError::NoFileName;
-    std::error_code ec;
-    std::filesystem::path filepath(filename);
-
-    if(std::filesystem::exists(filepath, ec)){
-        return FileError::FileExists;
-    }
-    if(ec) return FileError::CreateFailure;
 
-    std::ofstream create(filename);
+    // "x" fails on an existing file, so no separate exists check is needed.
+    std::FILE *create = std::fopen(filename.c_str(), "wx");
     if(!create){
-        ec = std::make_error_code(static_cast<std::errc>(errno));
-        if(ec == std::errc::permission_denied) return FileError::PermissionDenied;
-        if(ec == std::errc::no_space_on_device) return FileError::DiskFull;
+        if(errno == EEXIST) return FileError::FileExists;
+        if(errno == EACCES || errno == EPERM) return FileError::PermissionDenied;
+        if(errno == ENOSPC) return FileError::DiskFull;
         return FileError::CreateFailure;
     }
+    std::fclose(create);
+    noteFileChanged(filename);
     return FileError::Ok;
 }
 
 [[nodiscard]]
 FileError deleteFile(const std::string &filename){
-    FileError checkResult = checkFile(filename);
-    if(checkResult != FileError::Ok) return checkResult;
+    if(filename.empty()) return FileError::NoFileName;
 
     std::error_code ec;
     if(!std::filesystem::remove(filename, ec)){
+        if(!ec) return FileError::FileNotFound;
         if(ec == std::errc::permission_denied) return FileError::PermissionDenied;
         if(ec == std::errc::no_such_file_or_directory) return FileError::FileNotFound;
         return FileError::UnknownError;
     }
+    noteFileRemoved(filename);
     return FileError::Ok;
 }
 
@@ -59,9 +62,12 @@ FileError writeFile(const std::string &filename, const std::string &input){
     }
     std::ofstream outFile(filename, std::ios::app);
     if(!outFile) return FileError::WriteFailure;
-    outFile << input << std::endl;
+    outFile << input << '\n';
+    // Without the per-line flush of std::endl, write errors surface at close.
+    outFile.close();
     if(!outFile) return FileError::WriteFailure;
 
+    noteFileChanged(filename);
     return FileError::Ok;
 }
 
@@ -80,24 +86,6 @@ std::pair<std::ifstream, FileError> openFileForReading(const std::string &filena
     return {std::move(file), FileError::Ok};
 }
 
-[[nodiscard]]
-std::pair<std::vector<std::string>, FileError> readFileLines(const std::string& filename){
-    FileError checkResult = checkFile(filename);
-    if(checkResult != FileError::Ok) return {std::vector<std::string>(), checkResult};
-    
-    auto [file, err] = openFileForReading(filename);
-    if(err != FileError::Ok) return {std::vector<std::string>(), err};
-
-    std::vector<std::string> lines;
-    std::string line;
-    while(std::getline(file, line)){
-        lines.push_back(line);
-    }
-
-    if(lines.empty()) return {std::vector<std::string>(), FileError::EmptyFile};
-    return {lines, FileError::Ok};
-}
-
 [[nodiscard]]
 FileError listDirFiles(const std::filesystem::path &path){
     std::cout << "\n--- All Files ---\n";
@@ -113,14 +101,31 @@ FileError listDirFiles(const std::filesystem::path &path){
         return FileError::NotADirectory;
     }
 
+    // A cached snapshot answers without touching the directory again, as
+    // long as this directory itself has not changed since it was taken.
+    std::uint32_t entry = 0;
+    if(auto snapshot = cachedSnapshotContaining(path, entry); snapshot && snapshot->isCurrent(entry)){
+        OutputBuffer &output = threadOutputBuffer();
+        output.clear();
+        auto [first, last] = snapshot->children(entry);
+        for(std::uint32_t child = first; child < last; ++child){
+            output << snapshot->name(snapshot->nameId(child)) << '\n';
+        }
+        writeOutput(output);
+        return FileError::Ok;
+    }
+
     std::filesystem::directory_iterator dirIt(path, ec);
     if(ec){
         if(ec == std::errc::permission_denied) return FileError::PermissionDenied;
         return FileError::UnknownError;
     }
 
+    OutputBuffer &output = threadOutputBuffer();
+    output.clear();
     for(const auto &entry : dirIt){
-        std::cout << entry.path().filename().string() << "\n";
+        output << entry.path().filename().string() << '\n';
     }
+    writeOutput(output);
     return FileError::Ok;
 }
@@ -1,174 +1,276 @@
+#include <cctype>
+#include <charconv>
 #include <cstdint>
+#include <limits>
 #include <string_view>
 #include "flag_utils.hpp"
 #include "errors.hpp"
 
-std::string_view extractQuery(std::string_view sv){
-    size_t spacePos = sv.find(' ');
-    if (spacePos == std::string_view::npos) return {};
+namespace{
 
-    sv.remove_prefix(spacePos + 1);
-    size_t flagPos = sv.find("--");
-    sv = sv.substr(0, flagPos);
-    size_t end = sv.find_last_not_of(' ');
-    if(end == std::string_view::npos) return {};
+struct SizeUnit{
+    std::string_view name;
+    std::uintmax_t bytes;
+};
 
-    return sv.substr(0, end + 1);
+constexpr SizeUnit SIZE_UNITS[] = {{"KB", KB}, {"MB", MB}, {"GB", GB}};
+
+template<typename T>
+struct FlagChoice{
+    std::string_view word;
+    T value;
+};
+
+constexpr FlagChoice<OutputFormat> FORMATS[] = {{"text", OutputFormat::Text}, {"jsonl", OutputFormat::JsonLines}, {"null", OutputFormat::Null}};
+constexpr FlagChoice<SyncPolicy> SYNC_POLICIES[] = {{"none", SyncPolicy::None}, {"batch", SyncPolicy::Batch}, {"always", SyncPolicy::Always}};
+
+template<typename T>
+struct FieldOf;
+
+template<typename Config, typename T>
+struct FieldOf<T Config::*>{
+    using ConfigType = Config;
+    using Type = T;
+};
+
+template<auto Field>
+using ConfigOf = typename FieldOf<decltype(Field)>::ConfigType;
+
+// Stores a Number or Size flag's value in `Field`, rejecting values the
+// field's type cannot hold rather than letting them wrap.
+template<auto Field>
+FlagError storeNumber(const FlagArg& arg, ConfigOf<Field>& config){
+    using Type = typename FieldOf<decltype(Field)>::Type;
+    if(arg.number > static_cast<std::uintmax_t>(std::numeric_limits<Type>::max())) return FlagError::InvalidValue;
+    config.*Field = static_cast<Type>(arg.number);
+    return FlagError::Ok;
 }
 
-std::string_view skipWords(std::string_view sv){
-    size_t flagPos = sv.find_first_of("--");
-    if(flagPos == std::string_view::npos) return "";
+// --threads: at least one (the table's minimum) and at most maxThreadCount().
+template<auto Field>
+FlagError storeThreads(const FlagArg& arg, ConfigOf<Field>& config){
+    if(arg.number > maxThreadCount()) return FlagError::InvalidValue;
+    return storeNumber<Field>(arg, config);
+}
 
-    sv.remove_prefix(flagPos);
-    return sv;
+// Sets `Field` to `Value` when the switch is given.
+template<auto Field, auto Value>
+FlagError storeSwitch(const FlagArg&, ConfigOf<Field>& config){
+    config.*Field = Value;
+    return FlagError::Ok;
 }
 
-std::vector<std::string_view> tokenize(std::string_view sv){
-    std::vector<std::string_view> tokens;
+template<auto Field>
+FlagError storeText(const FlagArg& arg, ConfigOf<Field>& config){
+    config.*Field = arg.text;
+    return FlagError::Ok;
+}
 
-    while(!sv.empty()){
-        size_t space = sv.find(' ');
-        if(space == std::string_view::npos){
-            tokens.push_back(sv);
-            break;
+// Stores the value of the word in `Choices` that the flag names.
+template<auto Field, const auto& Choices>
+FlagError storeChoice(const FlagArg& arg, ConfigOf<Field>& config){
+    for(const auto &choice : Choices){
+        if(choice.word == arg.text){
+            config.*Field = choice.value;
+            return FlagError::Ok;
         }
-
-        tokens.push_back(sv.substr(0, space));
-        sv.remove_prefix(space + 1);
     }
-    return tokens;
+    return FlagError::InvalidValue;
 }
 
-bool isFlag(const std::string_view& flag){
-    if(!(flag.substr(0,2) == "--")){
-        return false;
+// --type, --glob and --exclude all feed the one name filter.
+template<auto Field>
+FlagError storeNameFilter(const FlagArg& arg, ConfigOf<Field>& config){
+    if(arg.name == "type") return (config.*Field).addTypes(arg.text);
+    (config.*Field).addGlob(arg.text, arg.name == "exclude");
+    return FlagError::Ok;
+}
+
+FlagError storeContext(const FlagArg& arg, SearchConfig& config){
+    if(arg.number > std::numeric_limits<std::size_t>::max()) return FlagError::InvalidValue;
+    std::size_t lines = static_cast<std::size_t>(arg.number);
+    if(arg.name != "after-context" && arg.name != "A") config.beforeContext = lines;
+    if(arg.name != "before-context" && arg.name != "B") config.afterContext = lines;
+    return FlagError::Ok;
+}
+
+template<typename Config>
+constexpr bool uniqueNames(const FlagSpec<Config>* specs, std::size_t count){
+    for(std::size_t i = 0; i < count; ++i){
+        for(std::size_t j = 0; j < count; ++j){
+            if(i == j) continue;
+            if(specs[i].name == specs[j].name || specs[i].name == specs[j].alias) return false;
+        }
     }
     return true;
 }
 
-std::pair<std::vector<ParsedArg>, FlagError> splitFlag(const std::vector<std::string_view>& flags){
-    std::vector<ParsedArg> results;
-    results.reserve(flags.size());
-
-    for(auto flag : flags){
-        ParsedArg arg;
-        
-        if(!isFlag(flag)) return {{}, FlagError::InvalidFlag};
-
-        flag.remove_prefix(2);
-
-        size_t eqPos = flag.find('=');
-        if(eqPos == std::string_view::npos){
-            arg.command = flag;
-            arg.value = "";
-            arg.unit = "";
-            arg.hasValue = false;
-            results.push_back(arg);
-            continue;
-        }
+template<typename Config, std::size_t N>
+constexpr bool uniqueNames(const FlagSpec<Config> (&specs)[N]){
+    return uniqueNames(specs, N);
+}
 
-        arg.command = flag.substr(0, eqPos);
-        flag.remove_prefix(eqPos + 1);
-        if(flag.empty()) return {{}, FlagError::EmptyParams};
+constexpr FlagSpec<SearchConfig> SEARCH_FLAG_SPECS[] = {
+    {"max-file-size", "mfs", FlagValue::Size, 0, storeNumber<&SearchConfig::maxFileSize>},
+    {"max-global-matches", "mgm", FlagValue::Number, 0, storeNumber<&SearchConfig::maxGlobalMatches>},
+    {"max-matches-per-file", "mmpf", FlagValue::Number, 0, storeNumber<&SearchConfig::maxMatchesPerFile>},
+    {"max-depth", "md", FlagValue::Number, 0, storeNumber<&SearchConfig::maxDepth>},
+    {"threads", "th", FlagValue::Number, 1, storeThreads<&SearchConfig::threads>},
+    {"index", "idx", FlagValue::None, 0, storeSwitch<&SearchConfig::useIndex, true>},
+    {"stats", "", FlagValue::None, 0, storeSwitch<&SearchConfig::showStats, true>},
+    {"no-uring", "", FlagValue::None, 0, storeSwitch<&SearchConfig::asyncRead, false>},
+    {"no-ignore", "", FlagValue::None, 0, storeSwitch<&SearchConfig::useIgnore, false>},
+    {"type", "", FlagValue::Text, 0, storeNameFilter<&SearchConfig::names>},
+    {"glob", "", FlagValue::Text, 0, storeNameFilter<&SearchConfig::names>},
+    {"exclude", "", FlagValue::Text, 0, storeNameFilter<&SearchConfig::names>},
+    {"format", "", FlagValue::Text, 0, storeChoice<&SearchConfig::format, FORMATS>},
+    {"before-context", "B", FlagValue::Number, 0, storeContext},
+    {"after-context", "A", FlagValue::Number, 0, storeContext},
+    {"context", "C", FlagValue::Number, 0, storeContext},
+    {"highlight", "hl", FlagValue::None, 0, storeSwitch<&SearchConfig::highlight, true>},
+};
+
+constexpr FlagSpec<FindConfig> FIND_FLAG_SPECS[] = {
+    {"threads", "th", FlagValue::Number, 1, storeThreads<&FindConfig::threads>},
+    {"sort", "", FlagValue::None, 0, storeSwitch<&FindConfig::sorted, true>},
+    {"max-depth", "md", FlagValue::Number, 0, storeNumber<&FindConfig::maxDepth>},
+    {"no-ignore", "", FlagValue::None, 0, storeSwitch<&FindConfig::useIgnore, false>},
+    {"type", "", FlagValue::Text, 0, storeNameFilter<&FindConfig::names>},
+    {"glob", "", FlagValue::Text, 0, storeNameFilter<&FindConfig::names>},
+    {"exclude", "", FlagValue::Text, 0, storeNameFilter<&FindConfig::names>},
+    {"format", "", FlagValue::Text, 0, storeChoice<&FindConfig::format, FORMATS>},
+};
+
+constexpr FlagSpec<ReadConfig> READ_FLAG_SPECS[] = {
+    {"from", "", FlagValue::Number, 1, storeNumber<&ReadConfig::fromLine>},
+    {"count", "", FlagValue::Number, 1, storeNumber<&ReadConfig::count>},
+    {"tail", "", FlagValue::Number, 1, storeNumber<&ReadConfig::tail>},
+};
+
+constexpr FlagSpec<AppendConfig> ADD_FLAG_SPECS[] = {
+    {"sync", "", FlagValue::Text, 0, storeChoice<&AppendConfig::sync, SYNC_POLICIES>},
+};
+
+constexpr FlagSpec<BulkConfig> CREATE_FLAG_SPECS[] = {
+    {"threads", "th", FlagValue::Number, 1, storeThreads<&BulkConfig::threads>},
+};
+
+constexpr FlagSpec<BulkConfig> DELETE_FLAG_SPECS[] = {
+    {"match", "", FlagValue::Text, 0, storeText<&BulkConfig::pattern>},
+    {"max-depth", "md", FlagValue::Number, 0, storeNumber<&BulkConfig::maxDepth>},
+    {"threads", "th", FlagValue::Number, 1, storeThreads<&BulkConfig::threads>},
+    {"no-ignore", "", FlagValue::None, 0, storeSwitch<&BulkConfig::useIgnore, false>},
+    {"dry-run", "", FlagValue::None, 0, storeSwitch<&BulkConfig::dryRun, true>},
+};
+
+static_assert(uniqueNames(SEARCH_FLAG_SPECS) && uniqueNames(FIND_FLAG_SPECS) && uniqueNames(READ_FLAG_SPECS)
+              && uniqueNames(ADD_FLAG_SPECS) && uniqueNames(CREATE_FLAG_SPECS) && uniqueNames(DELETE_FLAG_SPECS),
+              "a flag name or alias is listed twice");
 
-        size_t unitPos = flag.find_first_not_of("0123456789");
+}
 
-        if(unitPos == std::string_view::npos){
-            arg.value = flag;
-            arg.unit = "";
-            arg.hasValue = true;
-            results.push_back(arg);
-            continue;
-        }
+const FlagTable<SearchConfig> SEARCH_FLAGS{SEARCH_FLAG_SPECS};
+const FlagTable<FindConfig> FIND_FLAGS{FIND_FLAG_SPECS};
+const FlagTable<ReadConfig> READ_FLAGS{READ_FLAG_SPECS};
+const FlagTable<AppendConfig> ADD_FLAGS{ADD_FLAG_SPECS};
+const FlagTable<BulkConfig> CREATE_FLAGS{CREATE_FLAG_SPECS};
+const FlagTable<BulkConfig> DELETE_FLAGS{DELETE_FLAG_SPECS};
+const FlagTable<ListConfig> LIST_FLAGS{};
 
-        std::string_view number = flag.substr(0, unitPos);
-        if(number.empty()) return {{}, FlagError::NoValue};
+std::vector<std::string_view> tokenize(std::string_view sv){
+    std::vector<std::string_view> tokens;
 
-        std::string_view unit = flag.substr(unitPos);
-        if(unit.empty()) return {{}, FlagError::NoUnit};
+    while(!sv.empty()){
+        size_t space = sv.find(' ');
+        if(space == std::string_view::npos){
+            tokens.push_back(sv);
+            break;
+        }
 
-        arg.value = number;
-        arg.unit = unit;
-        arg.hasValue = true;
-        results.push_back(arg);
+        tokens.push_back(sv.substr(0, space));
+        sv.remove_prefix(space + 1);
     }
-    return {results, FlagError::Ok};
+    return tokens;
 }
 
-FlagError parseNumber(const std::string& num, uintmax_t& out){
+FlagError parseNumber(std::string_view num, uintmax_t& out){
+    if(num.empty()) return FlagError::InvalidValue;
     for(char c : num){
-        if(!isdigit(c)) return FlagError::InvalidValue;
+        if(!isdigit(static_cast<unsigned char>(c))) return FlagError::InvalidValue;
     }
 
-    try{
-        out = std::stoull(num);
-    }catch(...){
-        return FlagError::InvalidValue;
-    }
+    auto [end, ec] = std::from_chars(num.data(), num.data() + num.size(), out);
+    if(ec != std::errc() || end != num.data() + num.size()) return FlagError::InvalidValue;
     return FlagError::Ok;
 }
 
-FlagError parseSize(const ParsedArg& arg, uintmax_t& out){
-        uintmax_t num = 0;
-        FlagError parseNumberResult = parseNumber(arg.value, num);
-        if(parseNumberResult != FlagError::Ok) return parseNumberResult;
-
-        if(arg.unit == "KB"){
-            out = num * KB;
-        }else if(arg.unit == "MB"){
-            out = num * MB;
-        }else if(arg.unit == "GB"){
-            out = num * GB;
-        }else{
-            return FlagError::InvalidUnit;
-        }
-        return FlagError::Ok;
+std::string takeContextShorthand(std::string_view& query){
+    std::string flags;
+    while(true){
+        std::string_view rest = query.substr(0, query.find_last_not_of(' ') + 1);
+        std::size_t digits = rest.find_last_not_of("0123456789");
+        if(digits == std::string_view::npos || digits + 1 == rest.size()) break;
+        std::string_view number = rest.substr(digits + 1);
+        rest = rest.substr(0, rest.find_last_not_of(' ', digits) + 1);
+
+        // "-X" must stand alone and leave something to search for.
+        if(rest.size() < 4 || rest[rest.size() - 2] != '-' || rest[rest.size() - 3] != ' ') break;
+        char which = rest.back();
+        if(which != 'A' && which != 'B' && which != 'C') break;
+        if(rest.find_last_not_of(' ', rest.size() - 3) == std::string_view::npos) break;
+
+        flags.insert(0, "--" + std::string(1, which) + "=" + std::string(number) + (flags.empty() ? "" : " "));
+        query = rest.substr(0, rest.find_last_not_of(' ', rest.size() - 3) + 1);
+    }
+    return flags;
 }
 
-FlagError applyFlag(const ParsedArg& arg, SearchConfig& config){
-    std::string_view cmd = arg.command;
-
-    if(cmd == "max-file-size" || cmd == "mfs"){
-        if(!arg.hasValue) return FlagError::Ok;
-        if(arg.unit.empty()) return FlagError::NoUnit;
-
-        uintmax_t bytes = 0;
-        FlagError parseSizeResult = parseSize(arg, bytes);
-        if(parseSizeResult != FlagError::Ok) return parseSizeResult;
-
-        config.maxFileSize = bytes;
+FlagError nextFlag(std::string_view& params, std::string_view& name, std::string_view& text, bool& hasValue){
+    std::size_t start = params.find_first_not_of(' ');
+    if(start == std::string_view::npos){
+        params = {};
+        name = {};
         return FlagError::Ok;
-    }else if(cmd == "max-global-matches" || cmd == "mgm"){
-        if(!arg.hasValue) return FlagError::Ok;
-        if(!arg.unit.empty()) return FlagError::UnitNotAllowed; 
+    }
+    params.remove_prefix(start);
 
-        uintmax_t num = 0;
-        FlagError parseNumberResult = parseNumber(arg.value, num);
-        if(parseNumberResult != FlagError::Ok) return parseNumberResult;
+    std::size_t space = params.find(' ');
+    std::string_view flag = params.substr(0, space);
+    params.remove_prefix(space == std::string_view::npos ? params.size() : space);
 
-        config.maxGlobalMatches = static_cast<size_t>(num);
-        return FlagError::Ok;
-    }else if(cmd == "max-matches-per-file" || cmd == "mmpf"){
-        if(!arg.hasValue) return FlagError::Ok;
-        if(!arg.unit.empty()) return FlagError::UnitNotAllowed;
+    if(flag.size() <= 2 || flag.compare(0, 2, "--") != 0) return FlagError::InvalidFlag;
+    flag.remove_prefix(2);
 
-        uintmax_t num = 0;
-        FlagError parseNumResult = parseNumber(arg.value, num);
-        if(parseNumResult != FlagError::Ok) return parseNumResult;
+    std::size_t eqPos = flag.find('=');
+    name = flag.substr(0, eqPos);
+    hasValue = eqPos != std::string_view::npos;
+    text = hasValue ? flag.substr(eqPos + 1) : std::string_view();
+    if(name.empty()) return FlagError::InvalidFlag;
+    if(hasValue && text.empty()) return FlagError::EmptyParams;
+    return FlagError::Ok;
+}
 
-        config.maxMatchesPerFile = static_cast<size_t>(num);
-        return FlagError::Ok;
-    }else if(cmd == "max-depth" || cmd == "md"){
-        if(!arg.hasValue) return FlagError::Ok;
-        if(!arg.unit.empty()) return FlagError::UnitNotAllowed;
+FlagError readFlagValue(FlagValue value, std::uintmax_t min, bool hasValue, FlagArg& arg){
+    if(value == FlagValue::None) return hasValue ? FlagError::InvalidValue : FlagError::Ok;
+    if(!hasValue) return FlagError::NoValue;
+    if(value == FlagValue::Text) return FlagError::Ok;
+
+    std::string_view digits = arg.text.substr(0, arg.text.find_first_not_of("0123456789"));
+    std::string_view unit = arg.text.substr(digits.size());
+    FlagError err = parseNumber(digits, arg.number);
+    if(err != FlagError::Ok) return err;
 
-        uintmax_t num = 0;
-        FlagError parseNumResult = parseNumber(arg.value, num);
-        if(parseNumResult != FlagError::Ok) return parseNumResult;
+    if(value == FlagValue::Number){
+        if(!unit.empty()) return FlagError::UnitNotAllowed;
+        return arg.number < min ? FlagError::InvalidValue : FlagError::Ok;
+    }
 
-        config.maxDepth = static_cast<int>(num);
+    if(unit.empty()) return FlagError::NoUnit;
+    for(const auto &sizeUnit : SIZE_UNITS){
+        if(sizeUnit.name != unit) continue;
+        if(arg.number > std::numeric_limits<std::uintmax_t>::max() / sizeUnit.bytes) return FlagError::InvalidValue;
+        arg.number *= sizeUnit.bytes;
         return FlagError::Ok;
     }
-    return FlagError::UnknownFlag;
+    return FlagError::InvalidUnit;
 }
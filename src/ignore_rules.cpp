@@ -0,0 +1,220 @@
+#include <algorithm>
+#include "file_reader.hpp"
+#include "ignore_rules.hpp"
+#include "name_filter.hpp"
+
+namespace{
+
+constexpr const char* IGNORE_FILE_NAMES[] = {".gitignore", ".ignore"};
+
+std::shared_ptr<const IgnoreRules> loadRules(std::string_view dir){
+    // Most directories have no ignore file, so probing them allocates nothing
+    // until one is found.
+    std::shared_ptr<IgnoreRules> rules;
+    thread_local std::string path;
+    for(const char *fileName : IGNORE_FILE_NAMES){
+        path.assign(dir);
+        if(!path.empty() && path.back() != '/') path += '/';
+        path += fileName;
+
+        auto [file, err] = readWholeFile(path.c_str());
+        if(err != FileError::Ok) continue;
+        if(!rules) rules = std::make_shared<IgnoreRules>();
+        std::string_view content = file.view();
+        while(!content.empty()){
+            std::size_t nl = content.find('\n');
+            rules->add(content.substr(0, nl));
+            if(nl == std::string_view::npos) break;
+            content.remove_prefix(nl + 1);
+        }
+    }
+    if(!rules || rules->empty()) return nullptr;
+    return rules;
+}
+
+}
+
+void IgnoreRules::add(std::string_view line){
+    if(!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    // Trailing spaces are dropped unless escaped.
+    while(!line.empty() && line.back() == ' ' && !(line.size() >= 2 && line[line.size() - 2] == '\\')) line.remove_suffix(1);
+    if(line.empty() || line[0] == '#') return;
+
+    Rule rule;
+    if(line[0] == '!'){
+        rule.negated = true;
+        line.remove_prefix(1);
+    }else if(line[0] == '\\' && line.size() > 1 && (line[1] == '!' || line[1] == '#')){
+        line.remove_prefix(1);
+    }
+    if(!line.empty() && line.back() == '/'){
+        rule.dirOnly = true;
+        line.remove_suffix(1);
+    }
+    if(line.empty()) return;
+
+    // A slash at the start or in the middle anchors the rule to this
+    // directory; otherwise it matches a name at any depth.
+    std::size_t slash = line.find('/');
+    if(slash == 0){
+        line.remove_prefix(1);
+    }else if(slash == std::string_view::npos){
+        rule.basename = true;
+    }else if(line.substr(0, 3) == "**/" && line.find('/', 3) == std::string_view::npos){
+        line.remove_prefix(3);
+        rule.basename = true;
+    }
+    if(line.empty()) return;
+    rule.pattern = line;
+
+    auto index = static_cast<std::uint32_t>(rules.size());
+    rules.push_back(std::move(rule));
+    const Rule &added = rules.back();
+
+    const std::string &pattern = added.pattern;
+    bool literal = pattern.find_first_of("*?[\\") == std::string::npos;
+    if(literal){
+        Lookup &table = added.basename ? (added.dirOnly ? dirNames : names) : (added.dirOnly ? dirPaths : paths);
+        table[pattern] = index;
+    }else if(added.basename && pattern.size() > 2 && pattern[0] == '*' && pattern[1] == '.'
+             && pattern.find_first_of("*?[\\", 1) == std::string::npos){
+        (added.dirOnly ? dirSuffixes : suffixes)[pattern.substr(1)] = index;
+    }else{
+        globs.push_back(index);
+    }
+}
+
+void IgnoreRules::lookup(const Lookup& table, std::string_view key, std::int64_t& best){
+    if(table.empty()) return;
+    // Heterogeneous lookup needs C++20, so the key is copied into a reused string.
+    thread_local std::string probe;
+    probe.assign(key);
+    auto found = table.find(probe);
+    if(found != table.end()) best = std::max<std::int64_t>(best, found->second);
+}
+
+IgnoreVerdict IgnoreRules::match(std::string_view rel, std::string_view name, bool isDir) const{
+    std::int64_t best = -1;
+    lookup(names, name, best);
+    lookup(paths, rel, best);
+    if(isDir){
+        lookup(dirNames, name, best);
+        lookup(dirPaths, rel, best);
+    }
+    if(!suffixes.empty() || (isDir && !dirSuffixes.empty())){
+        for(std::size_t dot = name.find('.'); dot != std::string_view::npos; dot = name.find('.', dot + 1)){
+            lookup(suffixes, name.substr(dot), best);
+            if(isDir) lookup(dirSuffixes, name.substr(dot), best);
+        }
+    }
+
+    // Only a glob added after the best literal hit can overrule it.
+    for(auto it = globs.rbegin(); it != globs.rend() && static_cast<std::int64_t>(*it) > best; ++it){
+        const Rule &rule = rules[*it];
+        if(rule.dirOnly && !isDir) continue;
+        if(globMatch(rule.pattern, rule.basename ? name : rel)){
+            best = *it;
+            break;
+        }
+    }
+    if(best < 0) return IgnoreVerdict::None;
+    return rules[static_cast<std::size_t>(best)].negated ? IgnoreVerdict::Include : IgnoreVerdict::Ignore;
+}
+
+bool IgnoreScope::ignored(std::string_view name, bool isDir) const{
+    if(isDir && name == ".git") return true;
+    if(frames->empty()) return false;
+
+    thread_local std::string rel;
+    rel.assign(relDir);
+    rel.append(name);
+    for(auto it = frames->rbegin(); it != frames->rend(); ++it){
+        IgnoreVerdict verdict = it->rules->match(std::string_view(rel).substr(it->base), name, isDir);
+        if(verdict != IgnoreVerdict::None) return verdict == IgnoreVerdict::Ignore;
+    }
+    return false;
+}
+
+std::shared_ptr<const IgnoreScope> IgnoreScope::child(std::string_view name, std::string_view path, bool mayHaveRules) const{
+    std::shared_ptr<const IgnoreRules> rules = mayHaveRules ? loadRules(path) : nullptr;
+    // Without any rules only the `.git` check is left, which needs no path.
+    if(!rules && frames->empty()) return shared_from_this();
+
+    auto scope = std::make_shared<IgnoreScope>();
+    scope->relDir.reserve(relDir.size() + name.size() + 1);
+    scope->relDir.append(relDir).append(name).push_back('/');
+    if(rules){
+        auto extended = std::make_shared<std::vector<Frame>>(*frames);
+        extended->push_back({std::move(rules), scope->relDir.size()});
+        scope->frames = std::move(extended);
+    }else{
+        scope->frames = frames;
+    }
+    return scope;
+}
+
+std::shared_ptr<const IgnoreScope> ignoreScopeFor(const std::filesystem::path& root){
+    std::error_code ec;
+    std::filesystem::path start = std::filesystem::absolute(root, ec).lexically_normal();
+    if(ec) start = root;
+    if(!start.has_filename()) start = start.parent_path();
+
+    // Directories from the repository root down to `start`; just `start`
+    // when it is not inside a repository.
+    std::vector<std::filesystem::path> chain{start};
+    for(std::filesystem::path dir = start; ; ){
+        if(std::filesystem::exists(dir / ".git", ec)){
+            break;
+        }
+        std::filesystem::path parent = dir.parent_path();
+        if(parent == dir || parent.empty()){
+            chain.resize(1);
+            break;
+        }
+        chain.push_back(parent);
+        dir = std::move(parent);
+    }
+    std::reverse(chain.begin(), chain.end());
+
+    auto scope = std::make_shared<IgnoreScope>();
+    auto frames = std::make_shared<std::vector<IgnoreScope::Frame>>();
+    for(std::size_t i = 0; i < chain.size(); ++i){
+        if(i > 0){
+            scope->relDir += chain[i].filename().string();
+            scope->relDir += '/';
+        }
+        if(auto rules = loadRules(chain[i].string())) frames->push_back({std::move(rules), scope->relDir.size()});
+    }
+    scope->frames = std::move(frames);
+    return scope;
+}
+
+IgnorePathFilter::IgnorePathFilter(const std::filesystem::path& root) : root(root.string()), rootScope(ignoreScopeFor(root)){
+    while(this->root.size() > 1 && this->root.back() == '/') this->root.pop_back();
+}
+
+bool IgnorePathFilter::ignored(std::string_view path, bool isDir){
+    if(path.size() <= root.size() + 1 || path.compare(0, root.size(), root) != 0 || path[root.size()] != '/') return false;
+    std::string_view rel = path.substr(root.size() + 1);
+
+    std::size_t slash = rel.rfind('/');
+    const IgnoreScope *scope = slash == std::string_view::npos ? rootScope.get() : scopeOf(rel.substr(0, slash));
+    if(!scope) return true;
+    return scope->ignored(slash == std::string_view::npos ? rel : rel.substr(slash + 1), isDir);
+}
+
+const IgnoreScope* IgnorePathFilter::scopeOf(std::string_view relDir){
+    std::string key(relDir);
+    auto found = dirs.find(key);
+    if(found != dirs.end()) return found->second.get();
+
+    std::size_t slash = relDir.rfind('/');
+    const IgnoreScope *parent = slash == std::string_view::npos ? rootScope.get() : scopeOf(relDir.substr(0, slash));
+    std::string_view name = slash == std::string_view::npos ? relDir : relDir.substr(slash + 1);
+
+    std::shared_ptr<const IgnoreScope> scope;
+    if(parent && !parent->ignored(name, true)) scope = parent->child(name, root + '/' + key);
+    const IgnoreScope *result = scope.get();
+    dirs.emplace(std::move(key), std::move(scope));
+    return result;
+}
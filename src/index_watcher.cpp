@@ -0,0 +1,357 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include "ignore_rules.hpp"
+#include "index_watcher.hpp"
+#include "tree_snapshot.hpp"
+#include "trigram_index.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace{
+
+constexpr auto WATCH_QUIET_PERIOD = std::chrono::milliseconds(100);
+constexpr auto WATCH_SAVE_INTERVAL = std::chrono::seconds(5);
+constexpr std::size_t WATCH_MAX_PENDING = 4096;
+
+// Events read but not yet applied. `changedDirs` holds the directories
+// whose entries were added or removed.
+struct PendingChanges{
+    std::unordered_set<std::string> changedFiles;
+    std::unordered_set<std::string> removed;
+    std::unordered_set<std::string> newDirs;
+    std::unordered_set<std::string> changedDirs;
+    bool overflow = false;
+
+    bool empty() const { return changedFiles.empty() && removed.empty() && newDirs.empty() && changedDirs.empty() && !overflow; }
+    std::size_t size() const { return changedFiles.size() + removed.size() + newDirs.size() + changedDirs.size(); }
+};
+
+// Everything but `running` and `thread` is guarded by indexMtx.
+struct WatchState{
+    std::mutex indexMtx;
+    TrigramIndex index;
+    bool dirty = false;
+    PendingChanges pending;
+    // The search's ignore rules below the root; rebuilt when an ignore file changes.
+    std::unique_ptr<IgnorePathFilter> ignore;
+
+    std::unordered_map<int, std::string> wdPaths;
+    int inotifyFd = -1;
+    int wakeFd = -1;
+    std::atomic<bool> running{false};
+    std::thread thread;
+};
+
+std::mutex activeMtx;
+std::unique_ptr<WatchState> active;
+
+bool isIndexFile(const std::string& rel){
+    return rel == INDEX_FILE_NAME || rel == std::string(INDEX_FILE_NAME) + ".tmp";
+}
+
+std::string joinRel(const std::string& dir, const std::string& name){
+    return dir.empty() ? name : dir + "/" + name;
+}
+
+bool isIgnoreFile(const std::string& rel){
+    std::string_view name(rel);
+    std::size_t slash = name.rfind('/');
+    if(slash != std::string_view::npos) name.remove_prefix(slash + 1);
+    return name == ".gitignore" || name == ".ignore";
+}
+
+std::string parentRel(const std::string& rel){
+    std::size_t slash = rel.rfind('/');
+    return slash == std::string::npos ? std::string() : rel.substr(0, slash);
+}
+
+bool ignoredRel(WatchState& state, const std::string& rel, bool isDir){
+    return !rel.empty() && state.ignore->ignored((state.index.root / rel).native(), isDir);
+}
+
+void saveLocked(WatchState& state){
+    compactIndex(state.index);
+    refreshDirTimes(state.index);
+    FileError saveResult = saveIndex(state.index);
+    if(saveResult != FileError::Ok) matchFileError(saveResult);
+    state.dirty = false;
+}
+
+#ifdef __linux__
+constexpr std::uint32_t WATCH_EVENTS = IN_CREATE | IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_DELETE |
+                                       IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+
+void addWatch(WatchState& state, const std::string& rel){
+    int wd = inotify_add_watch(state.inotifyFd, (state.index.root / rel).c_str(), WATCH_EVENTS);
+    if(wd >= 0) state.wdPaths[wd] = rel;
+}
+
+// Watches `rel` and the directories below it that a search would enter;
+// `.git` and ignored directories get no watch.
+void addWatchTree(WatchState& state, const std::string& rel){
+    if(ignoredRel(state, rel, true)) return;
+    addWatch(state, rel);
+    std::error_code ec;
+    for(std::filesystem::recursive_directory_iterator it(state.index.root / rel, std::filesystem::directory_options::skip_permission_denied, ec);
+        !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)){
+        std::error_code stat_ec;
+        if(!it->is_directory(stat_ec) || it->is_symlink(stat_ec)) continue;
+        std::string sub = it->path().lexically_relative(state.index.root).generic_string();
+        if(ignoredRel(state, sub, true)){
+            it.disable_recursion_pending();
+            continue;
+        }
+        addWatch(state, sub);
+    }
+}
+
+void readEvents(WatchState& state, PendingChanges& pending){
+    alignas(inotify_event) char buffer[64 * 1024];
+    while(true){
+        ssize_t len = read(state.inotifyFd, buffer, sizeof(buffer));
+        if(len <= 0) return;
+
+        for(char *p = buffer; p < buffer + len;){
+            const inotify_event *ev = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + ev->len;
+
+            if(ev->mask & IN_Q_OVERFLOW){
+                pending.overflow = true;
+                continue;
+            }
+            auto dir = state.wdPaths.find(ev->wd);
+            if(dir == state.wdPaths.end()) continue;
+            if(ev->mask & (IN_DELETE_SELF | IN_IGNORED)){
+                if(ev->mask & IN_IGNORED) state.wdPaths.erase(dir);
+                continue;
+            }
+            if(ev->len == 0) continue;
+
+            std::string rel = joinRel(dir->second, ev->name);
+            if(isIndexFile(rel)) continue;
+            if(ev->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) pending.changedDirs.insert(dir->second);
+
+            if(ev->mask & IN_ISDIR){
+                if(ev->mask & (IN_CREATE | IN_MOVED_TO)) pending.newDirs.insert(rel);
+                if(ev->mask & (IN_DELETE | IN_MOVED_FROM)) pending.removed.insert(rel);
+                continue;
+            }
+            if(ev->mask & (IN_DELETE | IN_MOVED_FROM)) pending.removed.insert(rel);
+            if(ev->mask & (IN_CREATE | IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_MOVED_TO)) pending.changedFiles.insert(rel);
+        }
+    }
+}
+
+void applyChanges(WatchState& state){
+    PendingChanges &pending = state.pending;
+    if(pending.overflow){
+        state.ignore = std::make_unique<IgnorePathFilter>(state.index.root);
+        refreshIndex(state.index);
+        dropSnapshots(state.index.root);
+    }else{
+        // A changed ignore file can bring back directories that were never
+        // watched or indexed, so its directory is walked again.
+        std::unordered_set<std::string> ruleDirs;
+        for(const auto &set : {&pending.removed, &pending.changedFiles}){
+            for(const auto &rel : *set){
+                if(isIgnoreFile(rel)) ruleDirs.insert(parentRel(rel));
+            }
+        }
+        if(!ruleDirs.empty()) state.ignore = std::make_unique<IgnorePathFilter>(state.index.root);
+
+        for(const auto &rel : pending.removed) removeIndexedPath(state.index, rel);
+        for(const auto &rel : pending.newDirs){
+            if(ignoredRel(state, rel, true)) continue;
+            addWatchTree(state, rel);
+            addIndexedTree(state.index, rel);
+        }
+        for(const auto &rel : pending.changedFiles){
+            if(!ignoredRel(state, rel, false)) updateIndexedFile(state.index, rel);
+        }
+        for(const auto &rel : ruleDirs){
+            if(ignoredRel(state, rel, true)) continue;
+            addWatchTree(state, rel);
+            addIndexedTree(state.index, rel);
+        }
+        for(const auto &set : {&pending.changedDirs, &pending.removed}){
+            for(const auto &rel : *set) dropSnapshots(state.index.root / rel);
+        }
+    }
+    state.dirty = true;
+    pending = PendingChanges();
+}
+
+// Reads every event queued so far and applies it. inotify queues an event
+// as the change happens, so afterwards the index and the dropped snapshots
+// reflect the disk without a stat.
+void catchUp(WatchState& state){
+    readEvents(state, state.pending);
+    if(!state.pending.empty()) applyChanges(state);
+}
+
+void watchLoop(WatchState* state){
+    auto lastSave = std::chrono::steady_clock::now();
+
+    while(state->running.load()){
+        pollfd fds[2] = {{state->inotifyFd, POLLIN, 0}, {state->wakeFd, POLLIN, 0}};
+        int timeout = 1000;
+        {
+            std::lock_guard<std::mutex> lock(state->indexMtx);
+            if(!state->pending.empty()) timeout = static_cast<int>(WATCH_QUIET_PERIOD.count());
+        }
+        int ready = poll(fds, 2, timeout);
+        if(ready < 0) continue;
+        if(fds[1].revents & POLLIN) break;
+
+        std::lock_guard<std::mutex> lock(state->indexMtx);
+        if(fds[0].revents & POLLIN) readEvents(*state, state->pending);
+
+        // Apply once the tree has been quiet briefly so a burst of writes to
+        // one file costs a single re-read.
+        if(!state->pending.empty() && (ready == 0 || state->pending.size() >= WATCH_MAX_PENDING)){
+            applyChanges(*state);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if(ready == 0 && now - lastSave >= WATCH_SAVE_INTERVAL){
+            if(state->dirty) saveLocked(*state);
+            lastSave = now;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(state->indexMtx);
+    catchUp(*state);
+    if(state->dirty) saveLocked(*state);
+}
+#else
+void catchUp(WatchState&){}
+#endif
+
+}
+
+#ifdef __linux__
+FileError startWatching(const std::filesystem::path& root){
+    FileError stopResult = stopWatching();
+    if(stopResult != FileError::Ok) return stopResult;
+
+    auto state = std::make_unique<WatchState>();
+    auto [index, loadErr] = loadIndex(root);
+    if(loadErr == FileError::Ok){
+        refreshIndex(index);
+        state->dirty = true;
+    }else{
+        FileError buildErr = FileError::Ok;
+        std::tie(index, buildErr) = buildIndex(root);
+        if(buildErr != FileError::Ok) return buildErr;
+        state->dirty = true;
+    }
+    state->index = std::move(index);
+    state->ignore = std::make_unique<IgnorePathFilter>(state->index.root);
+
+    state->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(state->inotifyFd < 0) return FileError::UnknownError;
+    state->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(state->wakeFd < 0){
+        close(state->inotifyFd);
+        return FileError::UnknownError;
+    }
+    addWatchTree(*state, "");
+    // Snapshots taken before the watch may already be stale.
+    dropSnapshots(state->index.root);
+
+    state->running = true;
+    state->thread = std::thread(watchLoop, state.get());
+
+    std::lock_guard<std::mutex> lock(activeMtx);
+    active = std::move(state);
+    return FileError::Ok;
+}
+
+FileError stopWatching(){
+    std::unique_ptr<WatchState> state;
+    {
+        std::lock_guard<std::mutex> lock(activeMtx);
+        state = std::move(active);
+    }
+    if(!state) return FileError::Ok;
+
+    state->running = false;
+    // If the wake-up write fails the loop still sees `running` on its next poll timeout.
+    std::uint64_t one = 1;
+    ssize_t woken = write(state->wakeFd, &one, sizeof(one));
+    (void)woken;
+    if(state->thread.joinable()) state->thread.join();
+    close(state->inotifyFd);
+    close(state->wakeFd);
+    return FileError::Ok;
+}
+#else
+FileError startWatching(const std::filesystem::path&){
+    return FileError::NotSupported;
+}
+
+FileError stopWatching(){
+    return FileError::Ok;
+}
+#endif
+
+bool watchedRoot(std::filesystem::path& root){
+    std::lock_guard<std::mutex> lock(activeMtx);
+    if(!active) return false;
+    root = active->index.root;
+    return true;
+}
+
+void noteFileChanged(const std::filesystem::path& path){
+    std::lock_guard<std::mutex> lock(activeMtx);
+    if(!active) return;
+    std::lock_guard<std::mutex> indexLock(active->indexMtx);
+    std::string rel;
+    if(!indexRelativePath(active->index, path, rel) || rel.empty() || isIndexFile(rel)) return;
+    if(ignoredRel(*active, rel, false)) return;
+    updateIndexedFile(active->index, rel);
+    active->dirty = true;
+}
+
+void noteFileRemoved(const std::filesystem::path& path){
+    std::lock_guard<std::mutex> lock(activeMtx);
+    if(!active) return;
+    std::lock_guard<std::mutex> indexLock(active->indexMtx);
+    std::string rel;
+    if(!indexRelativePath(active->index, path, rel) || rel.empty()) return;
+    removeIndexedPath(active->index, rel);
+    active->dirty = true;
+}
+
+bool liveIndexCandidates(const std::filesystem::path& start, const std::vector<std::uint32_t>& trigrams, const SearchConfig& config, std::vector<std::filesystem::path>& out){
+    std::lock_guard<std::mutex> lock(activeMtx);
+    if(!active) return false;
+    std::lock_guard<std::mutex> indexLock(active->indexMtx);
+    std::string prefix;
+    if(!indexRelativePath(active->index, start, prefix)) return false;
+    catchUp(*active);
+    out = indexCandidates(active->index, trigrams, config, prefix, false);
+    return true;
+}
+
+bool watchCovers(const std::filesystem::path& path){
+    std::lock_guard<std::mutex> lock(activeMtx);
+    if(!active) return false;
+    std::lock_guard<std::mutex> indexLock(active->indexMtx);
+    std::string rel;
+    if(!indexRelativePath(active->index, path, rel) || ignoredRel(*active, rel, true)) return false;
+    catchUp(*active);
+    return true;
+}
@@ -1,10 +1,16 @@
 #include <iostream>
 #include <string>
-#include <sstream>
+#include <string_view>
 #include "config.hpp"
 #include "errors.hpp"
 #include "input_utils.hpp"
 #include "file_utils.hpp"
+#include "append_session.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define INPUT_UTILS_POSIX 1
+#endif
 
 [[nodiscard]]
 InputError parseInput(const std::string &input){
@@ -13,28 +19,56 @@ InputError parseInput(const std::string &input){
     return InputError::Ok;
 }
 
+namespace{
+
+constexpr const char* WHITESPACE = " \t\n\v\f\r";
+
+// Splits the first whitespace-separated word off `input`, leaving the rest
+// with its leading whitespace removed.
+std::string_view nextWord(std::string_view& input){
+    std::size_t start = input.find_first_not_of(WHITESPACE);
+    if(start == std::string_view::npos){
+        input = {};
+        return {};
+    }
+    input.remove_prefix(start);
+    std::string_view word = input.substr(0, input.find_first_of(WHITESPACE));
+    input.remove_prefix(word.size());
+    std::size_t rest = input.find_first_not_of(WHITESPACE);
+    input.remove_prefix(rest == std::string_view::npos ? input.size() : rest);
+    return word;
+}
+
+}
+
 [[nodiscard]]
-std::pair<std::string, InputError> parseCommand(const std::string &input){
-    std::string command, arg;
-    std::istringstream iss(input);
-    iss >> command;
-
-    iss >> std::ws;
-    std::getline(iss, arg);
-    if(arg.empty()) return {arg, InputError::EmptyField};
-    if(arg.length() > MAX_INPUT_LENGTH) return {arg, InputError::InputTooLong};
-    return {arg, InputError::Ok};
+std::pair<std::string_view, InputError> parseCommand(std::string_view input){
+    (void)nextWord(input);
+    if(input.empty()) return {input, InputError::EmptyField};
+    if(input.length() > MAX_INPUT_LENGTH) return {input, InputError::InputTooLong};
+    return {input, InputError::Ok};
 }
 
-void handleEditCommand(const std::string &filename){
+void handleEditCommand(const std::string& filename, const AppendConfig& config, std::istream& in){
+    AppendSession session(config.sync);
+    if(!handleFileError(session.open(filename))) return;
+
+    // Piped and batch-file lines skip the prompt, which would otherwise
+    // flush per line.
+    bool interactive = &in == &std::cin;
+#ifdef INPUT_UTILS_POSIX
+    interactive = interactive && isatty(STDIN_FILENO) == 1;
+#endif
     std::cout << "\nEditing file: '" << filename << "'\nEnter !exit to exit.\n";
     std::string edit;
     while(true){
-        std::cout << "> ";
-        if(!std::getline(std::cin, edit)){
+        if(interactive) std::cout << "> ";
+        if(!std::getline(in, edit)){
             std::cerr << "[ERROR] Input stream or EOF reached.\n";
             break;
         }
+        // Batch files may have CRLF line ends, as for the command lines.
+        if(!interactive && !edit.empty() && edit.back() == '\r') edit.pop_back();
 
         InputError err = parseInput(edit);
         if(!handleInputError(err)) continue;
@@ -43,22 +77,18 @@ void handleEditCommand(const std::string &filename){
             break;
         }
 
-        FileError writeResult = writeFile(filename, edit);
-        if(!handleFileError(writeResult)) break;
+        if(!handleFileError(session.append(edit))) break;
     }
+    (void)handleFileError(session.close());
 }
 
-Command matchCommand(const std::string &input){
-    std::istringstream iss(input);
-    std::string command;
-    iss >> command;
+Command matchCommand(std::string_view input){
+    std::string_view command = nextWord(input);
 
     if(command == "exit") return Command::Exit;
 
     if(command == "help"){
-        std::string helpSearch;
-        iss >> helpSearch;
-        if(helpSearch == "search") return Command::FlagDetails;
+        if(nextWord(input) == "search") return Command::FlagDetails;
         return Command::Help;
     }
 
@@ -69,6 +99,9 @@ Command matchCommand(const std::string &input){
     if(command == "find") return Command::Find;
     if(command == "search") return Command::Search;
     if(command == "delete") return Command::Delete;
+    if(command == "index") return Command::Index;
+    if(command == "watch") return Command::Watch;
+    if(command == "cache") return Command::Cache;
     return Command::InvalidCommand;
 }
 
@@ -76,12 +109,16 @@ void showCommands(){
     std::cout << "\n--- Commands ---\n";
     std::cout << "exit - Exit the program.\n";
     std::cout << "list - List all file names in directory.\n";
-    std::cout << "read [file name] - Print contents in a file by name.\n";
-    std::cout << "create [file name] - Create a new file.\n";
-    std::cout << "add [file name] - Append to a file by name.\n";
-    std::cout << "find [pattern] - Search for files matching pattern.\n";
+    std::cout << "read [file name] [--from=N] [--count=N] [--tail=N] - Print contents in a file by name, optionally a range of lines.\n";
+    std::cout << "create [file name] [--threads=N] - Create a new file. A range such as log{1..100}.txt creates every file in it.\n";
+    std::cout << "add [file name] [--sync=none|batch|always] - Append to a file by name. --sync sets when lines are flushed to disk.\n";
+    std::cout << "find [pattern] [--sort] [--threads=N] [--max-depth=N] [--type=T] [--glob=G] [--exclude=G] [--no-ignore] [--format=F] - Search for files matching pattern. --sort prints paths in order.\n";
     std::cout << "search [pattern] [flags] - Search for content in files matching pattern. Use 'help search' for flag details.\n";
     std::cout << "delete [file name] - Delete file.\n";
+    std::cout << "delete [dir] --match=[pattern] [--max-depth=N] [--threads=N] [--no-ignore] [--dry-run] - Delete every file under dir (default: current) whose name matches pattern. --dry-run only lists them.\n";
+    std::cout << "index build [dir] - Build a trigram index for 'search --index'.\n";
+    std::cout << "watch [dir] - Keep the index of a tree current in the background. 'watch stop' ends it.\n";
+    std::cout << "cache [clear | capacity N] - Show, clear or resize the compiled pattern cache.\n";
 }
 
 void showFlagDetails(){
@@ -90,13 +127,35 @@ void showFlagDetails(){
     std::cout << "Searches for content in files matching the given regex pattern.\n\n";
     std::cout << "Optional Flags:\n";
     std::cout << "  --max-file-size=<size><unit>       Maximum file size to search (requires unit: KB, MB, GB)\n";
-    std::cout << "                                     Default: 5MB\n\n";
+    std::cout << "                                     Default: 1GB\n\n";
     std::cout << "  --max-global-matches=<number>      Maximum total matches across all files\n";
     std::cout << "                                     Default: 500\n\n";
     std::cout << "  --max-matches-per-file=<number>    Maximum matches per individual file\n";
     std::cout << "                                     Default: 500\n\n";
     std::cout << "  --max-depth=<number>               Maximum directory depth to recurse\n";
     std::cout << "                                     Default: unlimited (-1)\n\n";
+    std::cout << "  --threads=<number>                 Number of file scanner threads (at most 4 per core)\n";
+    std::cout << "                                     Default: hardware concurrency\n\n";
+    std::cout << "  --index                            Use the trigram index built by 'index build'\n";
+    std::cout << "                                     Default: off\n\n";
+    std::cout << "  --stats                            Print counters and per-phase timings after the search\n";
+    std::cout << "                                     Default: off\n\n";
+    std::cout << "  --no-uring                         Read files on the scanner threads instead of through io_uring\n";
+    std::cout << "                                     Default: off\n\n";
+    std::cout << "  --no-ignore                        Also search files excluded by .gitignore and .ignore rules\n";
+    std::cout << "                                     Default: off\n\n";
+    std::cout << "  --type=<type>[,<type>...]          Only search files of these types (c, cpp, py, md, ...)\n";
+    std::cout << "  --glob=<glob>                      Only search files whose name matches the glob\n";
+    std::cout << "  --exclude=<glob>                   Skip files and directories whose name matches the glob\n";
+    std::cout << "                                     Each may be repeated. Default: all files\n\n";
+    std::cout << "  --format=<text|jsonl|null>         Print matches as text, JSON Lines or NUL-terminated fields\n";
+    std::cout << "                                     Default: text\n\n";
+    std::cout << "  --before-context=<number>          Lines to print before each match (--B)\n";
+    std::cout << "  --after-context=<number>           Lines to print after each match (--A)\n";
+    std::cout << "  --context=<number>                 Lines to print before and after each match (--C)\n";
+    std::cout << "                                     Default: 0\n\n";
+    std::cout << "  --highlight                        Mark each match within its line with terminal colors (--hl)\n";
+    std::cout << "                                     Default: off\n\n";
     std::cout << "Examples:\n";
     std::cout << "  search hello                                        Search for 'hello' with default settings\n";
     std::cout << "  search myFunction() --max-file-size=1MB             Search with 1MB file size limit\n";
@@ -0,0 +1,169 @@
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "file_reader.hpp"
+#include "file_utils.hpp"
+#include "line_reader.hpp"
+#include "output_sink.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#define LINE_READER_POSIX 1
+#endif
+
+namespace{
+
+// checkpoints[k] is the byte offset of line k * LINE_INDEX_STRIDE + 1.
+// Lines before `scannedTo` have been counted; once `complete` is set the
+// whole file has and `totalLines` is known.
+struct LineIndex{
+    FileIdentity identity;
+    std::vector<std::uint64_t> checkpoints{0};
+    std::uint64_t scannedLines = 0;
+    std::uint64_t scannedTo = 0;
+    std::uint64_t totalLines = 0;
+    bool complete = false;
+};
+
+std::mutex indexMtx;
+std::map<std::pair<std::uint64_t, std::uint64_t>, LineIndex> indexes;
+
+bool identify(const std::string& path, FileIdentity& out){
+#ifdef LINE_READER_POSIX
+    struct stat st;
+    if(::stat(path.c_str(), &st) != 0) return false;
+    out.device = static_cast<std::uint64_t>(st.st_dev);
+    out.inode = static_cast<std::uint64_t>(st.st_ino);
+#ifdef __APPLE__
+    out.mtime = static_cast<std::int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    out.mtime = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    out.size = static_cast<std::uint64_t>(st.st_size);
+#else
+    std::error_code ec;
+    out.inode = std::hash<std::string>{}(std::filesystem::absolute(path, ec).string());
+    out.mtime = static_cast<std::int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+    out.size = std::filesystem::file_size(path, ec);
+#endif
+    return true;
+}
+
+LineIndex& indexFor(const std::string& path, std::size_t contentSize){
+    FileIdentity identity;
+    if(!identify(path, identity)) identity.size = contentSize;
+
+    auto key = std::make_pair(identity.device, identity.inode);
+    auto found = indexes.find(key);
+    if(found != indexes.end()){
+        const FileIdentity &known = found->second.identity;
+        if(known.mtime == identity.mtime && known.size == identity.size && known.size == contentSize) return found->second;
+        indexes.erase(found);
+    }
+    if(indexes.size() >= MAX_CACHED_LINE_INDEXES) indexes.clear();
+
+    LineIndex &index = indexes[key];
+    index.identity = identity;
+    index.identity.size = contentSize;
+    return index;
+}
+
+// Records that the line starting at `index.scannedTo` ends just before `next`.
+void advance(LineIndex& index, std::uint64_t next, std::uint64_t size){
+    index.scannedTo = next;
+    ++index.scannedLines;
+    if(index.scannedLines % LINE_INDEX_STRIDE == 0) index.checkpoints.push_back(next);
+    if(next >= size){
+        index.complete = true;
+        index.totalLines = index.scannedLines;
+    }
+}
+
+// Counts lines until the index covers `line` or the end of the file.
+void extendTo(LineIndex& index, std::string_view content, std::uint64_t line){
+    while(!index.complete && index.scannedLines + 1 < line){
+        const char *start = content.data() + index.scannedTo;
+        const void *nl = std::memchr(start, '\n', content.size() - index.scannedTo);
+        if(!nl){
+            // A last line without a trailing newline still counts.
+            index.complete = true;
+            index.totalLines = index.scannedLines + 1;
+            return;
+        }
+        advance(index, static_cast<std::uint64_t>(static_cast<const char*>(nl) - content.data()) + 1, content.size());
+    }
+}
+
+// Byte offset of `line` (1-based), or false if the file is shorter.
+bool seekLine(LineIndex& index, std::string_view content, std::uint64_t line, std::uint64_t& offset){
+    extendTo(index, content, line);
+    if(index.complete && line > index.totalLines) return false;
+
+    std::uint64_t checkpoint = std::min<std::uint64_t>((line - 1) / LINE_INDEX_STRIDE, index.checkpoints.size() - 1);
+    offset = index.checkpoints[checkpoint];
+    for(std::uint64_t at = checkpoint * LINE_INDEX_STRIDE + 1; at < line; ++at){
+        const void *nl = std::memchr(content.data() + offset, '\n', content.size() - offset);
+        offset = static_cast<std::uint64_t>(static_cast<const char*>(nl) - content.data()) + 1;
+    }
+    return true;
+}
+
+}
+
+FileError streamFileLines(const std::string& filename, const ReadConfig& config){
+    FileError checkResult = checkFile(filename);
+    if(checkResult != FileError::Ok) return checkResult;
+
+    auto [file, readErr] = readWholeFile(filename.c_str());
+    if(readErr != FileError::Ok) return readErr;
+    std::string_view content = file.view();
+    if(content.empty()) return FileError::EmptyFile;
+
+    std::lock_guard<std::mutex> lock(indexMtx);
+    LineIndex &index = indexFor(filename, content.size());
+
+    std::uint64_t first = config.fromLine;
+    if(config.tail != 0){
+        extendTo(index, content, UINT64_MAX);
+        first = index.totalLines > config.tail ? index.totalLines - config.tail + 1 : 1;
+    }
+
+    OutputBuffer &output = threadOutputBuffer();
+    output.clear();
+
+    std::uint64_t offset = 0;
+    if(!seekLine(index, content, first, offset)){
+        output << "[INFO] File has only ";
+        output.appendNumber(index.totalLines) << " lines.\n";
+        writeOutput(output);
+        return FileError::Ok;
+    }
+
+    const std::uint64_t last = config.count != 0 ? first + config.count - 1 : UINT64_MAX;
+    std::uint64_t line = first;
+    while(offset < content.size() && line <= last){
+        const void *nl = std::memchr(content.data() + offset, '\n', content.size() - offset);
+        std::uint64_t end = nl ? static_cast<std::uint64_t>(static_cast<const char*>(nl) - content.data()) : content.size();
+
+        output.appendNumber(line) << ": " << content.substr(offset, end - offset) << '\n';
+        if(output.size() >= OUTPUT_BUFFER_SIZE) writeOutput(output);
+
+        // A sequential read extends the index as a side effect.
+        if(!index.complete && index.scannedTo == offset) advance(index, end + 1, content.size());
+        offset = end + 1;
+        ++line;
+    }
+
+    if(first == 1 && config.count == 0 && config.tail == 0){
+        output << "[INFO] Total lines: ";
+        output.appendNumber(line - 1) << '\n';
+    }else{
+        output << "[INFO] Lines ";
+        output.appendNumber(first) << '-';
+        output.appendNumber(line - 1) << '\n';
+    }
+    writeOutput(output);
+    return FileError::Ok;
+}
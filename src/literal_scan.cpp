@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "literal_scan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LITERAL_SCAN_X86 1
+#endif
+
+namespace{
+
+inline unsigned char foldByte(unsigned char c){
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c | 0x20) : c;
+}
+
+inline bool isAsciiLetter(unsigned char c){
+    return (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+}
+
+inline bool equalsFolded(const char* hay, const char* lowered, std::size_t len){
+    for(std::size_t i = 0; i < len; ++i){
+        if(foldByte(static_cast<unsigned char>(hay[i])) != static_cast<unsigned char>(lowered[i])) return false;
+    }
+    return true;
+}
+
+std::size_t findScalar(const char* hay, std::size_t n, const std::string& needle, std::size_t lastIndex, std::size_t i){
+    const std::size_t len = needle.size();
+    const unsigned char first = static_cast<unsigned char>(needle[0]);
+    for(; i + len <= n; ++i){
+        if(foldByte(static_cast<unsigned char>(hay[i])) != first) continue;
+        if(foldByte(static_cast<unsigned char>(hay[i + lastIndex])) != static_cast<unsigned char>(needle[lastIndex])) continue;
+        if(equalsFolded(hay + i, needle.data(), len)) return i;
+    }
+    return std::string_view::npos;
+}
+
+#ifdef LITERAL_SCAN_X86
+// Compares the first and last needle bytes against 16 (or 32) candidate
+// positions at once; letters are folded by OR-ing 0x20 before the compare.
+std::size_t findSse2(const char* hay, std::size_t n, const std::string& needle, std::size_t lastIndex){
+    const unsigned char first = static_cast<unsigned char>(needle[0]);
+    const unsigned char last = static_cast<unsigned char>(needle[lastIndex]);
+    const __m128i vFirst = _mm_set1_epi8(static_cast<char>(first));
+    const __m128i vLast = _mm_set1_epi8(static_cast<char>(last));
+    const __m128i foldFirst = _mm_set1_epi8(isAsciiLetter(first) ? 0x20 : 0);
+    const __m128i foldLast = _mm_set1_epi8(isAsciiLetter(last) ? 0x20 : 0);
+
+    std::size_t i = 0;
+    for(; i + lastIndex + 16 <= n; i += 16){
+        __m128i a = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i)), foldFirst);
+        __m128i b = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i + lastIndex)), foldLast);
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, vFirst), _mm_cmpeq_epi8(b, vLast))));
+        while(mask != 0){
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if(equalsFolded(hay + i + bit, needle.data(), needle.size())) return i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return findScalar(hay, n, needle, lastIndex, i);
+}
+
+__attribute__((target("avx2")))
+std::size_t findAvx2(const char* hay, std::size_t n, const std::string& needle, std::size_t lastIndex){
+    const unsigned char first = static_cast<unsigned char>(needle[0]);
+    const unsigned char last = static_cast<unsigned char>(needle[lastIndex]);
+    const __m256i vFirst = _mm256_set1_epi8(static_cast<char>(first));
+    const __m256i vLast = _mm256_set1_epi8(static_cast<char>(last));
+    const __m256i foldFirst = _mm256_set1_epi8(isAsciiLetter(first) ? 0x20 : 0);
+    const __m256i foldLast = _mm256_set1_epi8(isAsciiLetter(last) ? 0x20 : 0);
+
+    std::size_t i = 0;
+    for(; i + lastIndex + 32 <= n; i += 32){
+        __m256i a = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(hay + i)), foldFirst);
+        __m256i b = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(hay + i + lastIndex)), foldLast);
+        std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, vFirst), _mm256_cmpeq_epi8(b, vLast))));
+        while(mask != 0){
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if(equalsFolded(hay + i + bit, needle.data(), needle.size())) return i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return findScalar(hay, n, needle, lastIndex, i);
+}
+#endif
+
+using Kernel = std::size_t (*)(const char*, std::size_t, const std::string&, std::size_t);
+
+#ifndef LITERAL_SCAN_X86
+std::size_t findScalarKernel(const char* hay, std::size_t n, const std::string& needle, std::size_t lastIndex){
+    return findScalar(hay, n, needle, lastIndex, 0);
+}
+#endif
+
+struct KernelChoice{
+    Kernel fn;
+    const char* name;
+};
+
+KernelChoice pickKernel(){
+#ifdef LITERAL_SCAN_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) return {findAvx2, "avx2"};
+    return {findSse2, "sse2"};
+#else
+    return {findScalarKernel, "scalar"};
+#endif
+}
+
+const KernelChoice& kernel(){
+    static const KernelChoice choice = pickKernel();
+    return choice;
+}
+
+}
+
+LiteralFinder::LiteralFinder(std::string needle) : lowered(std::move(needle)){
+    for(char &c : lowered) c = static_cast<char>(foldByte(static_cast<unsigned char>(c)));
+    lastIndex = lowered.empty() ? 0 : lowered.size() - 1;
+}
+
+std::size_t LiteralFinder::find(std::string_view haystack, std::size_t from) const{
+    if(lowered.empty()) return from <= haystack.size() ? from : std::string_view::npos;
+    if(from >= haystack.size() || haystack.size() - from < lowered.size()) return std::string_view::npos;
+
+    std::size_t hit = kernel().fn(haystack.data() + from, haystack.size() - from, lowered, lastIndex);
+    if(hit == std::string_view::npos) return hit;
+    return hit + from;
+}
+
+const char* literalKernelName(){
+    return kernel().name;
+}
+
+std::vector<std::uint32_t> literalTrigrams(const std::vector<std::string>& literals){
+    std::vector<std::uint32_t> trigrams;
+    for(const auto &literal : literals){
+        for(std::size_t i = 0; i + 3 <= literal.size(); ++i){
+            trigrams.push_back(packTrigram(static_cast<unsigned char>(literal[i]), static_cast<unsigned char>(literal[i + 1]), static_cast<unsigned char>(literal[i + 2])));
+        }
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
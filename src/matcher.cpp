@@ -0,0 +1,34 @@
+#include "matcher.hpp"
+
+bool StdRegexMatcher::search(std::string_view text) const{
+    return std::regex_search(text.begin(), text.end(), re);
+}
+
+bool StdRegexMatcher::find(std::string_view text, std::size_t from, MatchSpan& span) const{
+    std::match_results<std::string_view::const_iterator> m;
+    auto flags = from == 0 ? std::regex_constants::match_default : std::regex_constants::match_prev_avail;
+    if(!std::regex_search(text.begin() + from, text.end(), m, re, flags)) return false;
+    span.begin = from + static_cast<std::size_t>(m.position(0));
+    span.end = span.begin + static_cast<std::size_t>(m.length(0));
+    return true;
+}
+
+LiteralMatcher::LiteralMatcher(std::string literal){
+    LiteralInfo info;
+    info.finder = LiteralFinder(std::move(literal));
+    info.required.push_back(info.finder.needle());
+    info.pure = true;
+    setLiteralInfo(std::move(info));
+}
+
+bool LiteralMatcher::search(std::string_view text) const{
+    return literalInfo().finder.find(text) != std::string_view::npos;
+}
+
+bool LiteralMatcher::find(std::string_view text, std::size_t from, MatchSpan& span) const{
+    std::size_t hit = literalInfo().finder.find(text, from);
+    if(hit == std::string_view::npos) return false;
+    span.begin = hit;
+    span.end = hit + literalInfo().finder.needle().size();
+    return true;
+}
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+#include "name_filter.hpp"
+
+namespace{
+
+// Bracket expression at the start of `p` against `c`. Returns the length of
+// the expression, or 0 if it is not closed and '[' is a literal.
+std::size_t matchClass(std::string_view p, char c, bool& matched){
+    std::size_t i = 1;
+    bool negate = i < p.size() && (p[i] == '!' || p[i] == '^');
+    if(negate) ++i;
+    bool found = false;
+    bool first = true;
+    for(; i < p.size() && (p[i] != ']' || first); first = false){
+        char low = p[i];
+        if(low == '\\' && i + 1 < p.size()) low = p[++i];
+        char high = low;
+        if(i + 2 < p.size() && p[i + 1] == '-' && p[i + 2] != ']'){
+            high = p[i + 2];
+            if(high == '\\' && i + 3 < p.size()) high = p[++i + 2];
+            i += 2;
+        }
+        if(c >= low && c <= high) found = true;
+        ++i;
+    }
+    if(i >= p.size()) return 0;
+    matched = found != negate && c != '/';
+    return i + 1;
+}
+
+// Patterns each --type name stands for.
+struct FileType{
+    std::string_view name;
+    std::string_view patterns;
+};
+
+constexpr FileType FILE_TYPES[] = {
+    {"c", "*.c *.h"},
+    {"cpp", "*.cpp *.cc *.cxx *.c++ *.hpp *.hh *.hxx *.h++ *.h *.inl *.ipp"},
+    {"cmake", "CMakeLists.txt *.cmake"},
+    {"cs", "*.cs"},
+    {"css", "*.css *.scss"},
+    {"go", "*.go"},
+    {"html", "*.html *.htm"},
+    {"java", "*.java"},
+    {"js", "*.js *.mjs *.cjs *.jsx"},
+    {"json", "*.json"},
+    {"make", "Makefile makefile GNUmakefile *.mk *.mak"},
+    {"md", "*.md *.markdown"},
+    {"py", "*.py *.pyi"},
+    {"rust", "*.rs"},
+    {"sh", "*.sh *.bash *.zsh"},
+    {"toml", "*.toml"},
+    {"ts", "*.ts *.tsx"},
+    {"txt", "*.txt"},
+    {"yaml", "*.yaml *.yml"},
+};
+
+// FNV-1a mixed with a seed.
+std::uint32_t hashKey(std::string_view key, std::uint32_t seed){
+    std::uint32_t h = 2166136261u ^ seed;
+    for(char c : key){
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+// Suffixes up to this length get a test with the length fixed at compile
+// time, which the compiler turns into a few word compares.
+constexpr std::size_t MAX_FIXED_SUFFIX = 16;
+
+template <std::size_t N>
+bool hasFixedSuffix(std::string_view name, const char* suffix, std::size_t){
+    return name.size() >= N && std::memcmp(name.data() + name.size() - N, suffix, N) == 0;
+}
+
+bool hasSuffix(std::string_view name, const char* suffix, std::size_t length){
+    return name.size() >= length && std::memcmp(name.data() + name.size() - length, suffix, length) == 0;
+}
+
+template <std::size_t... N>
+constexpr std::array<bool (*)(std::string_view, const char*, std::size_t), sizeof...(N)> fixedSuffixTests(std::index_sequence<N...>){
+    return {{&hasFixedSuffix<N>...}};
+}
+
+constexpr auto FIXED_SUFFIX_TESTS = fixedSuffixTests(std::make_index_sequence<MAX_FIXED_SUFFIX + 1>());
+
+bool isLiteral(std::string_view text){
+    return text.find_first_of("*?[\\") == std::string_view::npos;
+}
+
+}
+
+bool globMatch(std::string_view p, std::string_view t){
+    while(!p.empty()){
+        if(p[0] == '*'){
+            if(p.size() >= 2 && p[1] == '*'){
+                std::string_view rest = p.substr(2);
+                if(!rest.empty() && rest[0] == '/'){
+                    rest.remove_prefix(1);
+                    if(globMatch(rest, t)) return true;
+                    for(std::size_t i = 0; i < t.size(); ++i){
+                        if(t[i] == '/' && globMatch(rest, t.substr(i + 1))) return true;
+                    }
+                    return false;
+                }
+                for(std::size_t i = 0; i <= t.size(); ++i){
+                    if(globMatch(rest, t.substr(i))) return true;
+                }
+                return false;
+            }
+            std::string_view rest = p.substr(1);
+            for(std::size_t i = 0; ; ++i){
+                if(globMatch(rest, t.substr(i))) return true;
+                if(i == t.size() || t[i] == '/') return false;
+            }
+        }
+        if(t.empty()) return false;
+
+        std::size_t used = 1;
+        if(p[0] == '?'){
+            if(t[0] == '/') return false;
+        }else if(p[0] == '['){
+            bool matched = false;
+            used = matchClass(p, t[0], matched);
+            if(used == 0){
+                if(t[0] != '[') return false;
+                used = 1;
+            }else if(!matched){
+                return false;
+            }
+        }else if(p[0] == '\\' && p.size() > 1){
+            if(p[1] != t[0]) return false;
+            used = 2;
+        }else if(p[0] != t[0]){
+            return false;
+        }
+        p.remove_prefix(used);
+        t.remove_prefix(1);
+    }
+    return t.empty();
+}
+
+
+void PerfectHashSet::insert(std::string_view key){
+    if(contains(key)) return;
+    keys.emplace_back(key);
+    rebuild();
+}
+
+bool PerfectHashSet::contains(std::string_view key) const{
+    if(slots.empty()) return false;
+    return slots[hashKey(key, seed) & mask] == key;
+}
+
+void PerfectHashSet::rebuild(){
+    // Sets are small (a few dozen names at most), so trying seeds until one
+    // spreads every key to its own slot is quick.
+    std::size_t size = 4;
+    while(size < keys.size() * 2) size *= 2;
+    for(;; size *= 2){
+        for(std::uint32_t trySeed = 1; trySeed <= 64; ++trySeed){
+            std::vector<std::string> table(size);
+            bool clash = false;
+            for(const auto &key : keys){
+                std::string &slot = table[hashKey(key, trySeed) & (size - 1)];
+                // Empty strings never become keys, so an empty slot is free.
+                if(!slot.empty()){
+                    clash = true;
+                    break;
+                }
+                slot = key;
+            }
+            if(clash) continue;
+            slots = std::move(table);
+            seed = trySeed;
+            mask = static_cast<std::uint32_t>(size - 1);
+            return;
+        }
+    }
+}
+
+void NameFilter::PatternSet::add(std::string_view pattern){
+    if(pattern.empty()) return;
+    if(isLiteral(pattern)){
+        names.insert(pattern);
+        return;
+    }
+    if(pattern.size() > 1 && pattern[0] == '*' && isLiteral(pattern.substr(1))){
+        std::string_view suffix = pattern.substr(1);
+        // "*.ext" with a single extension is a hash lookup on the part after
+        // the last dot.
+        if(suffix[0] == '.' && suffix.size() > 1 && suffix.find('.', 1) == std::string_view::npos){
+            extensions.insert(suffix.substr(1));
+            return;
+        }
+        SuffixTest test = suffix.size() <= MAX_FIXED_SUFFIX ? FIXED_SUFFIX_TESTS[suffix.size()] : hasSuffix;
+        suffixes.push_back({std::string(suffix), test});
+        return;
+    }
+    // Whatever follows the last wildcard must end the name, which rules out
+    // most names before the glob itself runs.
+    std::size_t wild = pattern.find_last_of("*?]\\");
+    globs.push_back({std::string(pattern), wild == std::string_view::npos ? 0 : pattern.size() - wild - 1});
+}
+
+bool NameFilter::PatternSet::matches(std::string_view name) const{
+    if(!extensions.empty()){
+        std::size_t dot = name.rfind('.');
+        if(dot != std::string_view::npos && extensions.contains(name.substr(dot + 1))) return true;
+    }
+    if(!names.empty() && names.contains(name)) return true;
+    for(const auto &suffix : suffixes){
+        if(suffix.test(name, suffix.text.data(), suffix.text.size())) return true;
+    }
+    for(const auto &glob : globs){
+        if(glob.tail > 0 && !hasSuffix(name, glob.pattern.data() + glob.pattern.size() - glob.tail, glob.tail)) continue;
+        if(globMatch(glob.pattern, name)) return true;
+    }
+    return false;
+}
+
+bool NameFilter::acceptsPath(std::string_view rel) const{
+    std::size_t slash;
+    while((slash = rel.find('/')) != std::string_view::npos){
+        if(slash > 0 && !acceptsDirectory(rel.substr(0, slash))) return false;
+        rel.remove_prefix(slash + 1);
+    }
+    return acceptsFile(rel);
+}
+
+FlagError NameFilter::addTypes(std::string_view list){
+    while(!list.empty()){
+        std::size_t comma = list.find(',');
+        std::string_view name = list.substr(0, comma);
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+        if(name.empty()) continue;
+
+        const FileType *type = std::find_if(std::begin(FILE_TYPES), std::end(FILE_TYPES), [name](const FileType &t){ return t.name == name; });
+        if(type == std::end(FILE_TYPES)) return FlagError::InvalidValue;
+
+        std::string_view patterns = type->patterns;
+        while(!patterns.empty()){
+            std::size_t space = patterns.find(' ');
+            include.add(patterns.substr(0, space));
+            patterns.remove_prefix(space == std::string_view::npos ? patterns.size() : space + 1);
+        }
+    }
+    return FlagError::Ok;
+}
+
+void NameFilter::addGlob(std::string_view pattern, bool exclude){
+    (exclude ? this->exclude : include).add(pattern);
+}
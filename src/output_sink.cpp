@@ -0,0 +1,102 @@
+#include <cerrno>
+#include <charconv>
+#include <iostream>
+#include <mutex>
+#include "config.hpp"
+#include "output_sink.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define OUTPUT_SINK_POSIX 1
+#endif
+
+namespace{
+
+struct Sink{
+    std::mutex mtx;
+    std::string pending;
+    bool lineBuffered = false;
+
+    Sink(){
+#ifdef OUTPUT_SINK_POSIX
+        lineBuffered = isatty(STDOUT_FILENO) == 1;
+#endif
+        pending.reserve(OUTPUT_BUFFER_SIZE);
+    }
+};
+
+Sink& sink(){
+    static Sink instance;
+    return instance;
+}
+
+void writeAll(std::string_view text){
+    // Text already sitting in std::cout's buffer was printed first.
+    std::cout.flush();
+#ifdef OUTPUT_SINK_POSIX
+    while(!text.empty()){
+        ssize_t n = ::write(STDOUT_FILENO, text.data(), text.size());
+        if(n < 0){
+            if(errno == EINTR) continue;
+            return;
+        }
+        text.remove_prefix(static_cast<std::size_t>(n));
+    }
+#else
+    std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+    std::cout.flush();
+#endif
+}
+
+void flushLocked(Sink& out){
+    if(out.pending.empty()) return;
+    writeAll(out.pending);
+    out.pending.clear();
+}
+
+}
+
+OutputBuffer& OutputBuffer::appendNumber(std::uint64_t value){
+    char digits[20];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    (void)ec;
+    data.append(digits, static_cast<std::size_t>(end - digits));
+    return *this;
+}
+
+OutputBuffer& threadOutputBuffer(){
+    thread_local OutputBuffer buffer;
+    return buffer;
+}
+
+void writeOutput(std::string_view text){
+    if(text.empty()) return;
+    Sink &out = sink();
+    std::lock_guard<std::mutex> lock(out.mtx);
+
+    if(out.lineBuffered){
+        flushLocked(out);
+        writeAll(text);
+        return;
+    }
+    if(out.pending.size() + text.size() > OUTPUT_BUFFER_SIZE){
+        flushLocked(out);
+        // A block this large gains nothing from another copy.
+        if(text.size() >= OUTPUT_BUFFER_SIZE){
+            writeAll(text);
+            return;
+        }
+    }
+    out.pending.append(text.data(), text.size());
+}
+
+void writeOutput(OutputBuffer& buffer){
+    writeOutput(buffer.view());
+    buffer.clear();
+}
+
+void flushOutput(){
+    Sink &out = sink();
+    std::lock_guard<std::mutex> lock(out.mtx);
+    flushLocked(out);
+}
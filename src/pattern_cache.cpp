@@ -0,0 +1,116 @@
+#include <cctype>
+#include <iostream>
+#include "config.hpp"
+#include "pattern_cache.hpp"
+
+namespace{
+
+// Case-insensitive patterns that differ only in letter case compile to the
+// same matcher, so their letters are folded. Escapes such as \d and \D keep
+// their case, which carries meaning, and so do bracket expressions: under
+// icase [A-z] still covers the punctuation between Z and a, [a-z] does not.
+std::string cacheKey(const std::string& pattern, bool icase){
+    std::string key;
+    key.reserve(pattern.size() + 1);
+    key.push_back(icase ? 'i' : 'c');
+    if(!icase){
+        key += pattern;
+        return key;
+    }
+
+    bool bracket = false;
+    for(std::size_t i = 0; i < pattern.size(); ++i){
+        char ch = pattern[i];
+        if(ch == '\\' && i + 1 < pattern.size()){
+            key.push_back(ch);
+            key.push_back(pattern[++i]);
+            continue;
+        }
+        if(!bracket){
+            bracket = ch == '[';
+            key.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(ch))));
+            continue;
+        }
+        // A class name such as [:alpha:] inside the brackets holds a ']' that
+        // does not close them.
+        if(ch == '[' && i + 1 < pattern.size() && (pattern[i + 1] == ':' || pattern[i + 1] == '.' || pattern[i + 1] == '=')){
+            std::size_t close = pattern.find(std::string{pattern[i + 1], ']'}, i + 2);
+            if(close != std::string::npos){
+                key.append(pattern, i, close + 2 - i);
+                i = close + 1;
+                continue;
+            }
+        }
+        if(ch == ']') bracket = false;
+        key.push_back(ch);
+    }
+    return key;
+}
+
+}
+
+PatternCache::PatternCache(std::size_t capacity) : capacity(capacity) {}
+
+MatcherPtr PatternCache::find(const std::string& pattern, bool icase){
+    std::lock_guard<std::mutex> lock(mtx);
+    auto found = lookup.find(cacheKey(pattern, icase));
+    if(found == lookup.end()){
+        ++misses;
+        return nullptr;
+    }
+    ++hits;
+    entries.splice(entries.begin(), entries, found->second);
+    return found->second->second;
+}
+
+MatcherPtr PatternCache::insert(const std::string& pattern, bool icase, MatcherPtr matcher){
+    std::lock_guard<std::mutex> lock(mtx);
+    if(capacity == 0) return matcher;
+
+    std::string key = cacheKey(pattern, icase);
+    auto found = lookup.find(key);
+    if(found != lookup.end()){
+        entries.splice(entries.begin(), entries, found->second);
+        return found->second->second;
+    }
+    entries.emplace_front(key, std::move(matcher));
+    lookup.emplace(std::move(key), entries.begin());
+    evictLocked();
+    return entries.front().second;
+}
+
+void PatternCache::setCapacity(std::size_t newCapacity){
+    std::lock_guard<std::mutex> lock(mtx);
+    capacity = newCapacity;
+    evictLocked();
+}
+
+void PatternCache::clear(){
+    std::lock_guard<std::mutex> lock(mtx);
+    entries.clear();
+    lookup.clear();
+}
+
+PatternCacheStats PatternCache::stats() const{
+    std::lock_guard<std::mutex> lock(mtx);
+    return {hits, misses, evictions, entries.size(), capacity};
+}
+
+void PatternCache::evictLocked(){
+    while(entries.size() > capacity){
+        lookup.erase(entries.back().first);
+        entries.pop_back();
+        ++evictions;
+    }
+}
+
+PatternCache& patternCache(){
+    static PatternCache cache(PATTERN_CACHE_CAPACITY);
+    return cache;
+}
+
+void printPatternCacheStats(){
+    PatternCacheStats cacheStats = patternCache().stats();
+    std::cout << "Pattern cache: " << cacheStats.hits << " hits, " << cacheStats.misses << " misses, " << cacheStats.evictions << " evictions, "
+              << cacheStats.size << "/" << cacheStats.capacity << " entries\n";
+}
@@ -3,145 +3,666 @@
 #include <iostream>
 #include <regex>
 #include <filesystem>
-#include <fstream>
-#include <array>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <tuple>
 #include "errors.hpp"
 #include "config.hpp"
+#include "thread_pool.hpp"
+#include "file_reader.hpp"
+#include "trigram_index.hpp"
+#include "index_watcher.hpp"
+#include "dir_walker.hpp"
+#include "tree_snapshot.hpp"
+#include "matcher.hpp"
+#include "output_sink.hpp"
+#include "search_stats.hpp"
+#include "dfa_matcher.hpp"
+#include "async_reader.hpp"
+#include "pattern_cache.hpp"
+#include "result_format.hpp"
+#include "content_type.hpp"
+#include "ignore_rules.hpp"
+#include "regex_utils.hpp"
 
-[[nodiscard]]
-std::pair<std::regex, RegexError> compileRegex(const std::string &pattern){
-    if(pattern.empty()) return {std::regex(), RegexError::EmptyPattern};
-    if(pattern.size() > MAX_INPUT_LENGTH) return {std::regex(), RegexError::InputTooLong};
+static std::pair<MatcherPtr, RegexError> compileUncached(const std::string &pattern){
+    auto [dfa, dfaErr] = compileDfaMatcher(pattern, true);
+    if(dfaErr == RegexError::Ok){
+        if(dfa->literalInfo().pure){
+            return {std::make_shared<LiteralMatcher>(dfa->literalInfo().finder.needle()), RegexError::Ok};
+        }
+        return {dfa, RegexError::Ok};
+    }
 
     try{
         std::regex re(pattern, std::regex::ECMAScript | std::regex::icase);
-        return {re, RegexError::Ok};
+        return {std::make_shared<StdRegexMatcher>(std::move(re)), RegexError::Ok};
     }catch(const std::regex_error &e){
         std::cerr << "[ERROR] " << e.what() << "\n";
-        return {std::regex(), RegexError::InternalRegexError};
+        return {nullptr, RegexError::InternalRegexError};
     }
 }
 
 [[nodiscard]]
-std::pair<std::vector<std::string>, RegexError> findFilesByName(const std::regex &re, const std::filesystem::path &start = std::filesystem::current_path()){
-    std::vector<std::string> matchingFiles;
-    std::error_code ec;
+std::pair<MatcherPtr, RegexError> compileRegex(const std::string &pattern){
+    if(pattern.empty()) return {nullptr, RegexError::EmptyPattern};
+    if(pattern.size() > MAX_INPUT_LENGTH) return {nullptr, RegexError::InputTooLong};
 
-    for(std::filesystem::recursive_directory_iterator it(start, ec); it != std::filesystem::recursive_directory_iterator(); it.increment(ec)){
-        if(ec){
-            if(ec == std::errc::permission_denied){
-                ec.clear();
-                continue;
+    PatternCache &cache = patternCache();
+    if(MatcherPtr cached = cache.find(pattern, true)) return {cached, RegexError::Ok};
+
+    auto [matcher, err] = compileUncached(pattern);
+    if(err != RegexError::Ok) return {nullptr, err};
+    return {cache.insert(pattern, true, std::move(matcher)), RegexError::Ok};
+}
+
+namespace{
+
+// Shared by the tasks of one parallel name search over a snapshot.
+struct FindState{
+    const TreeSnapshot &tree;
+    const Matcher &matcher;
+    const FindConfig &config;
+    const std::function<void(std::vector<std::string_view>&)> &emit;
+    WorkStealingPool &pool;
+    // Per interned name: -1 untested, 0 no match, 1 match (pattern and
+    // name filters both pass).
+    std::unique_ptr<std::atomic<signed char>[]> nameMatches;
+    std::atomic<bool> found{false};
+    std::mutex batchMtx;
+    std::vector<std::vector<std::string_view>> batches;
+    // Ignore rules at the root, null with --no-ignore.
+    const IgnoreScope *rootScope = nullptr;
+};
+
+bool nameMatches(FindState& state, std::uint32_t id){
+    signed char known = state.nameMatches[id].load(std::memory_order_relaxed);
+    if(known < 0){
+        std::string_view name = state.tree.name(id);
+        known = state.matcher.search(name) && state.config.names.acceptsFile(name) ? 1 : 0;
+        state.nameMatches[id].store(known, std::memory_order_relaxed);
+    }
+    return known == 1;
+}
+
+// True if directory `dir` of the snapshot holds an ignore file.
+bool hasIgnoreFile(const TreeSnapshot& tree, std::uint32_t dir){
+    auto [first, last] = tree.children(dir);
+    for(std::uint32_t entry = first; entry < last; ++entry){
+        std::string_view name = tree.name(tree.nameId(entry));
+        if(name == ".gitignore" || name == ".ignore") return true;
+    }
+    return false;
+}
+
+// Matches the files of directory `dir`, which sits `depth` levels below
+// the root's children, under the ignore rules of `scope` (null with
+// --no-ignore). Subdirectories become tasks of their own, so a deep tree
+// spreads over every worker.
+void findInDirectory(FindState& state, std::uint32_t dir, int depth, const IgnoreScope* scope){
+    std::error_code ec;
+    // Paths live in the worker's arena until the pool shuts down, after the
+    // last batch has been emitted.
+    Arena &arena = threadArena();
+    std::vector<std::string_view> matches;
+    auto [first, last] = state.tree.children(dir);
+    for(std::uint32_t entry = first; entry < last; ++entry){
+        EntryType type = state.tree.type(entry);
+        if(type == EntryType::Directory){
+            if(state.config.maxDepth >= 0 && depth + 1 > state.config.maxDepth) continue;
+            std::string_view name = state.tree.name(state.tree.nameId(entry));
+            // `.git` is pruned even with --no-ignore.
+            if(name == ".git" || !state.config.names.acceptsDirectory(name)) continue;
+            std::shared_ptr<const IgnoreScope> child;
+            if(scope){
+                if(scope->ignored(name, true)) continue;
+                // The snapshot shows whether the directory has ignore files,
+                // so only those are read from disk.
+                bool mayHaveRules = hasIgnoreFile(state.tree, entry);
+                child = scope->child(name, mayHaveRules ? state.tree.pathOf(entry, arena) : std::string_view(), mayHaveRules);
+            }
+            if(!child || child.get() == state.rootScope){
+                // Where no ignore file applies every directory shares the
+                // root scope, so the task stays small enough not to allocate.
+                state.pool.submit([&state, entry, depth]{ findInDirectory(state, entry, depth + 1, state.rootScope); });
             }else{
-                std::cerr << "[ERROR] Filesystem error while iterating: " << ec.message() << "\n";
-                return {matchingFiles, RegexError::UnknownError};
+                state.pool.submit([&state, entry, depth, child]{ findInDirectory(state, entry, depth + 1, child.get()); });
             }
+            continue;
         }
+        if(type != EntryType::File && type != EntryType::Symlink) continue;
+        if(!nameMatches(state, state.tree.nameId(entry))) continue;
+        if(scope && scope->ignored(state.tree.name(state.tree.nameId(entry)), false)) continue;
 
-        const std::filesystem::directory_entry &entry = *it;
+        std::string_view path = state.tree.pathOf(entry, arena);
+        if(type == EntryType::Symlink && !std::filesystem::is_regular_file(std::filesystem::path(path), ec)) continue;
+        matches.push_back(path);
+    }
+    if(matches.empty()) return;
 
-        std::error_code stat_ec;
-        if(!entry.is_regular_file(stat_ec)){
-            if(stat_ec == std::errc::permission_denied) continue;
-            continue;
-        }
+    state.found.store(true, std::memory_order_relaxed);
+    if(!state.config.sorted){
+        state.emit(matches);
+        return;
+    }
+    std::sort(matches.begin(), matches.end());
+    std::lock_guard<std::mutex> lock(state.batchMtx);
+    state.batches.push_back(std::move(matches));
+}
 
-        std::string filename = entry.path().filename().string();
-        if(std::regex_search(filename, re)){
-            matchingFiles.push_back(entry.path().string());
+// Merges sorted batches pairwise, one round of merges in parallel at a time.
+std::vector<std::string_view> mergeSorted(std::vector<std::vector<std::string_view>> batches, WorkStealingPool& pool){
+    if(batches.empty()) return {};
+    while(batches.size() > 1){
+        std::vector<std::vector<std::string_view>> merged((batches.size() + 1) / 2);
+        for(std::size_t i = 0; i < merged.size(); ++i){
+            if(2 * i + 1 == batches.size()){
+                merged[i] = std::move(batches[2 * i]);
+                continue;
+            }
+            pool.submit([&batches, &merged, i]{
+                auto &left = batches[2 * i];
+                auto &right = batches[2 * i + 1];
+                merged[i].reserve(left.size() + right.size());
+                std::merge(std::make_move_iterator(left.begin()), std::make_move_iterator(left.end()),
+                           std::make_move_iterator(right.begin()), std::make_move_iterator(right.end()), std::back_inserter(merged[i]));
+            });
         }
+        pool.wait();
+        batches.swap(merged);
     }
+    return std::move(batches.front());
+}
 
-    if(matchingFiles.empty()) return {matchingFiles, RegexError::NoFileFound};
-    return {matchingFiles, RegexError::Ok};
 }
 
 [[nodiscard]]
-RegexError findInFile(const std::string &pattern, const std::regex &re, SearchConfig& config, const std::filesystem::path &start){
-    if(pattern.empty()) return RegexError::EmptyPattern;
+RegexError findFilesByName(const Matcher &matcher, const FindConfig &config, const std::function<void(std::vector<std::string_view>&)> &emit, const std::filesystem::path &start){
+    // Under a watch, events drop the snapshots they touch, so a cached one
+    // needs no mtime check. Ignored directories are not watched, so
+    // --no-ignore always checks.
+    bool watched = config.useIgnore && watchCovers(start);
+    auto [snapshot, snapshotErr] = snapshotFor(start, config.threads, watched);
+    if(snapshotErr != FileError::Ok) return RegexError::NoFileFound;
 
-    std::error_code ec;
-    bool found =  false;
-    size_t totalGlobalMatches = 0;
+    // Names are interned, so each distinct name is matched once no matter
+    // how many directories repeat it.
+    WorkStealingPool pool(config.threads);
+    FindState state{*snapshot, matcher, config, emit, pool, std::make_unique<std::atomic<signed char>[]>(snapshot->nameCount()), {}, {}, {}};
+    for(std::size_t id = 0; id < snapshot->nameCount(); ++id) state.nameMatches[id].store(-1, std::memory_order_relaxed);
 
-    for(std::filesystem::recursive_directory_iterator it(start, ec); it != std::filesystem::recursive_directory_iterator(); it.increment(ec)){
-        if(ec){
-            if(ec == std::errc::permission_denied){
-                ec.clear();
-                continue;
-            }else{
-                std::cerr << "[ERROR] Filesystem error while iteration: " << ec.message() << "\n";
-                return RegexError::UnknownError;
+    std::shared_ptr<const IgnoreScope> scope;
+    if(config.useIgnore) scope = ignoreScopeFor(snapshot->root());
+    state.rootScope = scope.get();
+    pool.submit([&state]{ findInDirectory(state, 0, -1, state.rootScope); });
+    pool.wait();
+
+    if(!state.found.load()) return RegexError::NoFileFound;
+    if(config.sorted){
+        std::vector<std::string_view> sorted = mergeSorted(std::move(state.batches), pool);
+        emit(sorted);
+    }
+    return RegexError::Ok;
+}
+
+struct SearchState{
+    const Matcher &matcher;
+    const SearchConfig &config;
+    std::atomic<size_t> globalMatches{0};
+    std::atomic<bool> found{false};
+    std::atomic<bool> limitReached{false};
+    SearchStats *stats = nullptr;
+};
+
+static size_t countNewlines(const char *first, const char *last){
+    size_t count = 0;
+    while(first < last){
+        const void *nl = std::memchr(first, '\n', static_cast<size_t>(last - first));
+        if(!nl) break;
+        ++count;
+        first = static_cast<const char*>(nl) + 1;
+    }
+    return count;
+}
+
+static size_t lineEndAt(std::string_view content, size_t pos){
+    const void *nl = std::memchr(content.data() + pos, '\n', content.size() - pos);
+    if(!nl) return content.size();
+    return static_cast<size_t>(static_cast<const char*>(nl) - content.data());
+}
+
+static void countReadError(SearchStats *stats, FileError readErr){
+    if(!stats) return;
+    if(readErr == FileError::FileTooLarge) stats->add(StatCounter::SkippedSize);
+    else if(readErr == FileError::PermissionDenied) stats->add(StatCounter::SkippedPermission);
+    else if(readErr == FileError::Skipped) stats->add(StatCounter::SkippedBinary);
+    else stats->add(StatCounter::SkippedUnreadable);
+}
+
+// Human-readable output for one file. Matches arrive in file order, and the
+// lines between two of them are known not to match, so context lines are
+// read straight from the buffer as they are needed.
+class TextPrinter{
+public:
+    TextPrinter(OutputBuffer &output, std::string_view path, std::string_view content, const Matcher &matcher, const SearchConfig &config)
+        : output(output), path(path), content(content), matcher(matcher), config(config) {}
+
+    void match(size_t lineNumber, size_t lineStart, size_t lineEnd, const MatchSpan *first){
+        size_t contextStart = lineStart;
+        size_t contextLine = lineNumber;
+        flushAfter(lineStart);
+        // Step back over up to `before` lines that were not printed yet.
+        for(size_t i = 0; i < config.beforeContext && contextStart > printedTo; ++i){
+            contextStart = lineStartAt(contextStart - 1);
+            --contextLine;
+        }
+        if(output.empty()) output << '\n' << path << '\n';
+        else if(hasContext() && contextStart > printedTo) output << "--\n";
+
+        size_t pos = contextStart;
+        for(; contextLine < lineNumber; ++contextLine){
+            size_t end = lineEndAt(content, pos);
+            printLine(contextLine, '-', content.substr(pos, end - pos));
+            pos = end + 1;
+        }
+
+        std::string_view line = content.substr(lineStart, lineEnd - lineStart);
+        output.appendNumber(lineNumber) << ": ";
+        if(config.highlight) appendHighlighted(line, first);
+        else output << line;
+        output << '\n';
+
+        printedTo = lineEnd + 1;
+        printedLine = lineNumber + 1;
+        afterLeft = config.afterContext;
+    }
+
+    // Prints the after-context still owed to the last match.
+    void finish(){ flushAfter(content.size()); }
+
+private:
+    [[nodiscard]] bool hasContext() const { return config.beforeContext > 0 || config.afterContext > 0; }
+
+    size_t lineStartAt(size_t pos) const{
+        while(pos > 0 && content[pos - 1] != '\n') --pos;
+        return pos;
+    }
+
+    void printLine(size_t lineNumber, char separator, std::string_view line){
+        output.appendNumber(lineNumber) << separator << ' ' << line << '\n';
+    }
+
+    void flushAfter(size_t limit){
+        while(afterLeft > 0 && printedTo < limit && printedTo < content.size()){
+            size_t end = lineEndAt(content, printedTo);
+            printLine(printedLine, '-', content.substr(printedTo, end - printedTo));
+            printedTo = end + 1;
+            ++printedLine;
+            --afterLeft;
+        }
+    }
+
+    void appendHighlighted(std::string_view line, const MatchSpan *first){
+        size_t plain = 0;
+        forEachMatchSpan(line, matcher, first, [&](const MatchSpan &span){
+            output << line.substr(plain, span.begin - plain) << HIGHLIGHT_START << line.substr(span.begin, span.end - span.begin) << HIGHLIGHT_END;
+            plain = span.end;
+        });
+        output << line.substr(plain);
+    }
+
+    OutputBuffer &output;
+    std::string_view path;
+    std::string_view content;
+    const Matcher &matcher;
+    const SearchConfig &config;
+    size_t printedTo = 0;
+    size_t printedLine = 1;
+    size_t afterLeft = 0;
+};
+
+// `identity` is null when the file was read without an fstat, in which case
+// its classification is not cached.
+static void scanContent(std::string_view path, std::string_view content, const FileIdentity *identity, const Matcher &matcher, const SearchConfig &config, SearchState &state){
+    SearchStats *stats = state.stats;
+    if(stats) stats->add(StatCounter::BytesRead, content.size());
+
+    ScopedTimer binaryTimer(stats, StatPhase::BinaryCheck);
+    ContentKind kind = ContentKind::Text;
+    if(!identity || !cachedContentKind(*identity, kind)){
+        kind = classifyContent(content);
+        if(identity) rememberContentKind(*identity, kind);
+    }
+    if(kind == ContentKind::Binary){
+        binaryTimer.stop();
+        if(stats) stats->add(StatCounter::SkippedBinary);
+        return;
+    }
+    const bool transcoded = kind != ContentKind::Text;
+    if(transcoded){
+        content = searchableText(content, kind);
+        if(stats) stats->add(StatCounter::Transcoded);
+    }
+    binaryTimer.stop();
+
+    OutputBuffer &output = threadOutputBuffer();
+    output.clear();
+    TextPrinter printer(output, path, content, matcher, config);
+    size_t totalMatchesPerFile = 0;
+    size_t countedUpTo = 0;
+    size_t linesBefore = 0;
+    // For transcoded files records report the line's offset in the file:
+    // past the byte order mark plus the UTF-16 length of the text before it.
+    size_t mappedUpTo = 0;
+    size_t sourceOffset = 2;
+    bool perFileLimit = false;
+    // Spans are only worth finding when they get printed.
+    const bool wantSpans = config.format != OutputFormat::Text || config.highlight;
+
+    // Returns false once scanning of this file should stop. `first` is the
+    // line's leftmost match when the scan already found it.
+    auto report = [&](size_t lineStart, size_t lineEnd, const MatchSpan *first){
+        size_t slot = state.globalMatches.fetch_add(1, std::memory_order_relaxed);
+        if(slot >= config.maxGlobalMatches){
+            state.limitReached.store(true, std::memory_order_relaxed);
+            return false;
+        }
+        state.found.store(true, std::memory_order_relaxed);
+        ++totalMatchesPerFile;
+
+        linesBefore += countNewlines(content.data() + countedUpTo, content.data() + lineStart);
+        countedUpTo = lineStart;
+
+        if(config.format != OutputFormat::Text){
+            size_t offset = lineStart;
+            if(transcoded){
+                sourceOffset += utf16ByteLength(content.substr(mappedUpTo, lineStart - mappedUpTo));
+                mappedUpTo = lineStart;
+                offset = sourceOffset;
             }
+            appendMatchRecord(output, config.format, path, linesBefore + 1, offset, content.substr(lineStart, lineEnd - lineStart), matcher, first);
+        }else{
+            printer.match(linesBefore + 1, lineStart, lineEnd, first);
         }
 
-        const std::filesystem::directory_entry &entry = *it;
+        if(totalMatchesPerFile >= config.maxMatchesPerFile){
+            perFileLimit = true;
+            return false;
+        }
 
-        if(config.maxDepth >= 0 && it.depth() > config.maxDepth){
-            it.disable_recursion_pending();
+        if(slot + 1 >= config.maxGlobalMatches){
+            state.limitReached.store(true, std::memory_order_relaxed);
+            return false;
         }
+        return !state.limitReached.load(std::memory_order_relaxed);
+    };
 
-        std::error_code stat_ec;
-        if(!entry.is_regular_file(stat_ec)){
-            if(stat_ec == std::errc::permission_denied){
-                continue;
+    ScopedTimer matchTimer(stats, StatPhase::Match);
+    size_t linesScanned = 0;
+    size_t regexCalls = 0;
+    const LiteralInfo &literals = matcher.literalInfo();
+    MatchSpan span;
+    size_t pos = 0;
+    if(!literals.finder.empty()){
+        // Jump between literal hits; only lines holding one reach the matcher.
+        size_t hit = 0;
+        while(pos < content.size() && (hit = literals.finder.find(content, pos)) != std::string_view::npos){
+            size_t lineStart = hit;
+            while(lineStart > pos && content[lineStart - 1] != '\n') --lineStart;
+            size_t lineEnd = lineEndAt(content, hit);
+
+            std::string_view line = content.substr(lineStart, lineEnd - lineStart);
+            ++linesScanned;
+            regexCalls += !literals.pure;
+            bool matched = false;
+            const MatchSpan *first = nullptr;
+            if(literals.pure){
+                matched = true;
+                span.begin = hit - lineStart;
+                span.end = span.begin + literals.finder.needle().size();
+                first = &span;
+            }else if(wantSpans){
+                matched = matcher.find(line, 0, span);
+                first = &span;
+            }else{
+                matched = matcher.search(line);
             }
-            continue;
+            if(matched && !report(lineStart, lineEnd, first)) break;
+            pos = lineEnd + 1;
+        }
+    }else{
+        while(pos < content.size()){
+            size_t lineEnd = lineEndAt(content, pos);
+            std::string_view line = content.substr(pos, lineEnd - pos);
+            ++linesScanned;
+            ++regexCalls;
+            bool matched = wantSpans ? matcher.find(line, 0, span) : matcher.search(line);
+            if(matched && !report(pos, lineEnd, wantSpans ? &span : nullptr)) break;
+            pos = lineEnd + 1;
         }
+    }
+
+    matchTimer.stop();
+    if(stats){
+        stats->add(StatCounter::LinesScanned, linesScanned);
+        stats->add(StatCounter::RegexCalls, regexCalls);
+        stats->add(StatCounter::Matches, totalMatchesPerFile);
+    }
 
-        std::uintmax_t fileSize = entry.file_size(stat_ec);
-        if(stat_ec || fileSize > config.maxFileSize) continue;
-        
-        std::ifstream inFile(entry.path());
-        if(!inFile) continue;
+    if(output.empty()) return;
+    if(config.format == OutputFormat::Text){
+        printer.finish();
+        if(perFileLimit){
+            output << "[INFO] Maximum per-file match limit reached (";
+            output.appendNumber(config.maxMatchesPerFile) << "). Stopping.\n";
+        }
+    }
+    ScopedTimer outputTimer(stats, StatPhase::Output);
+    writeOutput(output);
+}
 
-        std::array<char, BINARY_CHECK_BUFFER_SIZE> buffer;
-        inFile.read(buffer.data(), buffer.size());
-        std::streamsize bytesRead = inFile.gcount();
+static void scanFile(const char *path, const Matcher &matcher, const SearchConfig &config, SearchState &state){
+    if(state.limitReached.load(std::memory_order_relaxed)) return;
 
-        bool isBinary = false;
-        for(std::streamsize i = 0; i < bytesRead; i++){
-            if(buffer[i] == '\0'){
-                isBinary = true;
-                break;
+    SearchStats *stats = state.stats;
+    if(stats) stats->add(StatCounter::FilesVisited);
+
+    ScopedTimer readTimer(stats, StatPhase::Read);
+    auto [file, readErr] = readWholeFile(path, config.maxFileSize, isCachedBinary);
+    readTimer.stop();
+    if(readErr != FileError::Ok){
+        countReadError(stats, readErr);
+        return;
+    }
+    scanContent(path, file.view(), &file.identity(), matcher, config, state);
+}
+
+// Matching stage behind an AsyncFileReader: runs on a pool worker until the
+// reader has handed out every file.
+static void scanReaderOutput(AsyncFileReader &reader, const Matcher &matcher, const SearchConfig &config, SearchState &state){
+    AsyncReadFile file;
+    while(true){
+        // Time spent waiting here is I/O the reader has not finished yet.
+        ScopedTimer waitTimer(state.stats, StatPhase::Read);
+        bool got = reader.next(file);
+        waitTimer.stop();
+        if(!got) break;
+
+        if(file.deferred){
+            scanFile(file.path.data(), matcher, config, state);
+        }else if(!state.limitReached.load(std::memory_order_relaxed)){
+            if(state.stats) state.stats->add(StatCounter::FilesVisited);
+            if(file.error != FileError::Ok){
+                countReadError(state.stats, file.error);
+            }else{
+                scanContent(file.path, file.view(), &file.identity, matcher, config, state);
             }
         }
+        reader.recycle(file);
+    }
+}
 
-        if(isBinary) continue;
+template <typename Submit>
+static RegexError walkSearchTree(const std::filesystem::path &start, const SearchConfig &config, SearchState &state, Arena &arena, Submit &&submit){
+    // Only paths go to the workers; the size limit is applied when the file
+    // is opened, so regular files cost no stat here.
+    // scopes[d] holds the ignore rules for entries at depth d. The walk is
+    // depth-first, so entering a directory only replaces deeper levels.
+    std::vector<std::shared_ptr<const IgnoreScope>> scopes;
+    if(config.useIgnore) scopes.push_back(ignoreScopeFor(start));
 
-        inFile.clear();
-        inFile.seekg(0);
+    FileError walkResult = walkTree(start, [&](const WalkEntry &entry){
+        if(state.limitReached.load(std::memory_order_relaxed)) return WalkAction::Stop;
+        bool isDir = entry.type() == EntryType::Directory;
+        // `.git` is pruned even with --no-ignore.
+        if(isDir && entry.name() == ".git") return WalkAction::SkipChildren;
+        if(isDir ? !config.names.acceptsDirectory(entry.name()) : !config.names.acceptsFile(entry.name())){
+            if(state.stats) state.stats->add(StatCounter::SkippedFiltered);
+            return isDir ? WalkAction::SkipChildren : WalkAction::Continue;
+        }
+        if(!scopes.empty() && scopes[static_cast<std::size_t>(entry.depth())]->ignored(entry.name(), isDir)){
+            if(state.stats) state.stats->add(StatCounter::SkippedIgnored);
+            return isDir ? WalkAction::SkipChildren : WalkAction::Continue;
+        }
+        if(isDir){
+            if(config.maxDepth >= 0 && entry.depth() > config.maxDepth) return WalkAction::SkipChildren;
+            if(!scopes.empty()){
+                std::size_t depth = static_cast<std::size_t>(entry.depth());
+                auto scope = scopes[depth]->child(entry.name(), entry.path(arena));
+                scopes.resize(depth + 1);
+                scopes.push_back(std::move(scope));
+            }
+            return WalkAction::Continue;
+        }
+        if(!entry.isRegularFile()) return WalkAction::Continue;
+        if(isKnownBinaryName(entry.name())){
+            // Skipped by name alone; the file is never opened.
+            if(state.stats){
+                state.stats->add(StatCounter::FilesVisited);
+                state.stats->add(StatCounter::SkippedBinary);
+            }
+            return WalkAction::Continue;
+        }
+        submit(entry.path(arena));
+        return WalkAction::Continue;
+    });
 
-        std::string line;
-        size_t lineNo = 0;
-        bool printedHeaderForFile = false;
-        size_t totalMatchesPerFile = 0;
-        while(std::getline(inFile, line)){
-            ++lineNo;
-            if(std::regex_search(line, re)){
-                found = true;
-                ++totalGlobalMatches;
-                ++totalMatchesPerFile;
+    // A missing or unreadable start directory simply has nothing to scan.
+    if(walkResult == FileError::UnknownError){
+        std::cerr << "[ERROR] Filesystem error while iteration.\n";
+        return RegexError::UnknownError;
+    }
+    return RegexError::Ok;
+}
 
-                if(!printedHeaderForFile){
-                    std::cout << "\n" << entry.path().string() << "\n";
-                    printedHeaderForFile = true;
-                }
-                std::cout << lineNo << ": " << line << "\n";
-                
-                if(totalMatchesPerFile >= config.maxMatchesPerFile){
-                    std::cout << "[INFO] Maximum per-file match limit reached (" << config.maxMatchesPerFile << "). Stopping.\n";
-                    break;
-                }
+[[nodiscard]]
+RegexError findInFile(const std::string &pattern, const Matcher &matcher, SearchConfig& config, const std::filesystem::path &start){
+    if(pattern.empty()) return RegexError::EmptyPattern;
+
+    SearchState state{matcher, config};
+    // Candidate paths for this search, freed together when it returns.
+    Arena arena;
+    std::unique_ptr<SearchStats> stats;
+    if(config.showStats) stats = std::make_unique<SearchStats>();
+    state.stats = stats.get();
+    auto searchStart = std::chrono::steady_clock::now();
+    RegexError walkResult = RegexError::Ok;
 
-                if(totalGlobalMatches >= config.maxGlobalMatches){
-                    std::cout << "[INFO] Maximum global match limit reached (" << config.maxGlobalMatches << "). Stopping.\n";
-                        return RegexError::Ok;
+    ScopedTimer walkTimer(state.stats, StatPhase::Walk);
+    std::vector<std::filesystem::path> liveCandidates;
+    // Only --index trusts an index; a plain search always walks the tree.
+    // The index leaves ignored files out, so --no-ignore walks as well.
+    bool useIndex = config.useIndex && config.useIgnore;
+    bool live = useIndex && liveIndexCandidates(start, matcher.literalInfo().trigrams, config, liveCandidates);
+
+    std::shared_ptr<const TrigramIndex> index;
+    if(useIndex && !live){
+        FileError loadResult = FileError::Ok;
+        std::tie(index, loadResult) = loadSharedIndex(start);
+        if(loadResult != FileError::Ok) return RegexError::IndexUnavailable;
+    }
+
+    {
+        // Prefer the io_uring reader stage; without it each pool task reads
+        // its own file.
+        std::unique_ptr<AsyncFileReader> reader;
+        if(config.asyncRead && asyncReadAvailable()){
+            reader = std::make_unique<AsyncFileReader>(ASYNC_READ_DEPTH, config.maxFileSize, isCachedBinary);
+            if(!reader->ok()) reader.reset();
+        }
+
+        WorkStealingPool pool(config.threads);
+        if(reader){
+            for(std::size_t i = 0; i < pool.size(); ++i){
+                pool.submit([&reader, &matcher, &config, &state]{ scanReaderOutput(*reader, matcher, config, state); });
+            }
+        }
+        // Paths are NUL-terminated arena strings, and a task captures just
+        // two pointers, which std::function stores without allocating.
+        auto submit = [&pool, &reader, &state](std::string_view path){
+            if(reader){
+                reader->submit(path);
+                return;
+            }
+            pool.submit([&state, path = path.data()]{
+                scanFile(path, state.matcher, state.config, state);
+            });
+        };
+
+        if(useIndex){
+            std::vector<std::filesystem::path> candidates = live ? std::move(liveCandidates) : indexCandidates(*index, matcher.literalInfo().trigrams, config);
+            std::unique_ptr<IgnorePathFilter> ignore;
+            if(config.useIgnore) ignore = std::make_unique<IgnorePathFilter>(start);
+            std::string root = start.native();
+            if(root.empty() || root.back() != '/') root += '/';
+            for(auto &path : candidates){
+                if(state.limitReached.load(std::memory_order_relaxed)) break;
+                // Candidates lie below `start`, so directory excludes apply
+                // to the part after it, as they would in the walk.
+                std::string_view full = path.native();
+                bool below = full.size() > root.size() && full.compare(0, root.size(), root) == 0;
+                std::string_view rel = below ? full.substr(root.size()) : std::string_view(path.filename().native());
+                if(!config.names.empty() && !config.names.acceptsPath(rel)){
+                    if(state.stats) state.stats->add(StatCounter::SkippedFiltered);
+                    continue;
+                }
+                if(ignore && ignore->ignored(path.native())){
+                    if(state.stats) state.stats->add(StatCounter::SkippedIgnored);
+                    continue;
                 }
+                submit(arena.copy(path.native()));
             }
+        }else{
+            walkResult = walkSearchTree(start, config, state, arena, submit);
         }
-        if(totalGlobalMatches >= config.maxGlobalMatches) return RegexError::Ok;
+        walkTimer.stop();
+        if(reader) reader->finish();
+        pool.wait();
     }
-    if(!found) return RegexError::NotInFiles;
-    return RegexError::Ok;
+
+    RegexError result = RegexError::Ok;
+    if(walkResult != RegexError::Ok){
+        result = walkResult;
+    }else if(state.limitReached.load() && config.format == OutputFormat::Text){
+        OutputBuffer &output = threadOutputBuffer();
+        output.clear();
+        output << "[INFO] Maximum global match limit reached (";
+        output.appendNumber(config.maxGlobalMatches) << "). Stopping.\n";
+        writeOutput(output);
+    }else if(!state.found.load()){
+        result = RegexError::NotInFiles;
+    }
+
+    flushOutput();
+    if(stats){
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - searchStart);
+        stats->print(static_cast<std::uint64_t>(elapsed.count()));
+        printPatternCacheStats();
+    }
+    return result;
 }
@@ -0,0 +1,126 @@
+#include "result_format.hpp"
+
+namespace{
+
+constexpr char hexDigits[] = "0123456789abcdef";
+
+// Length of the well-formed UTF-8 sequence starting at text[i], a byte of
+// 0x80 or above, or 0 if there is none (stray continuation bytes, overlong
+// forms, surrogates, code points past U+10FFFF, truncated sequences).
+std::size_t utf8SequenceLength(std::string_view text, std::size_t i){
+    unsigned char c = static_cast<unsigned char>(text[i]);
+    std::size_t length = 0;
+    unsigned char low = 0x80, high = 0xbf;
+    if(c >= 0xc2 && c <= 0xdf){
+        length = 2;
+    }else if(c == 0xe0){
+        length = 3;
+        low = 0xa0;
+    }else if(c == 0xed){
+        length = 3;
+        high = 0x9f;
+    }else if(c >= 0xe1 && c <= 0xef){
+        length = 3;
+    }else if(c == 0xf0){
+        length = 4;
+        low = 0x90;
+    }else if(c >= 0xf1 && c <= 0xf3){
+        length = 4;
+    }else if(c == 0xf4){
+        length = 4;
+        high = 0x8f;
+    }else{
+        return 0;
+    }
+    if(text.size() - i < length) return 0;
+
+    unsigned char second = static_cast<unsigned char>(text[i + 1]);
+    if(second < low || second > high) return 0;
+    for(std::size_t k = 2; k < length; ++k){
+        if((static_cast<unsigned char>(text[i + k]) & 0xc0) != 0x80) return 0;
+    }
+    return length;
+}
+
+}
+
+void appendJsonString(OutputBuffer& out, std::string_view text){
+    out << '"';
+    std::size_t plain = 0;
+    for(std::size_t i = 0; i < text.size(); ++i){
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if(c >= 0x80){
+            std::size_t length = utf8SequenceLength(text, i);
+            if(length > 0){
+                i += length - 1;
+                continue;
+            }
+            // JSON text must be UTF-8, so a byte that is not part of a valid
+            // sequence becomes U+FFFD.
+            out << text.substr(plain, i - plain) << "\\ufffd";
+            plain = i + 1;
+            continue;
+        }
+        if(c >= 0x20 && c != '"' && c != '\\' && c != 0x7f) continue;
+
+        out << text.substr(plain, i - plain);
+        plain = i + 1;
+        switch(c){
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\t': out << "\\t"; break;
+            case '\r': out << "\\r"; break;
+            case '\n': out << "\\n"; break;
+            default:
+                out << "\\u00" << hexDigits[c >> 4] << hexDigits[c & 0xf];
+                break;
+        }
+    }
+    out << text.substr(plain) << '"';
+}
+
+void appendMatchRecord(OutputBuffer& out, OutputFormat format, std::string_view path, std::uint64_t lineNumber,
+                       std::uint64_t offset, std::string_view line, const Matcher& matcher, const MatchSpan* first){
+    if(format == OutputFormat::JsonLines){
+        out << "{\"path\":";
+        appendJsonString(out, path);
+        out << ",\"line\":";
+        out.appendNumber(lineNumber) << ",\"offset\":";
+        out.appendNumber(offset) << ",\"spans\":[";
+        bool firstSpan = true;
+        forEachMatchSpan(line, matcher, first, [&](const MatchSpan& span){
+            if(!firstSpan) out << ',';
+            firstSpan = false;
+            out << '[';
+            out.appendNumber(span.begin) << ',';
+            out.appendNumber(span.end) << ']';
+        });
+        out << "],\"text\":";
+        appendJsonString(out, line);
+        out << "}\n";
+    }else if(format == OutputFormat::Null){
+        out << path << '\0';
+        out.appendNumber(lineNumber) << '\0';
+        out.appendNumber(offset) << '\0';
+        bool firstSpan = true;
+        forEachMatchSpan(line, matcher, first, [&](const MatchSpan& span){
+            if(!firstSpan) out << ',';
+            firstSpan = false;
+            out.appendNumber(span.begin) << '-';
+            out.appendNumber(span.end);
+        });
+        out << '\0' << line << '\0';
+    }
+}
+
+void appendPathRecord(OutputBuffer& out, OutputFormat format, std::string_view path){
+    if(format == OutputFormat::JsonLines){
+        out << "{\"path\":";
+        appendJsonString(out, path);
+        out << "}\n";
+    }else if(format == OutputFormat::Null){
+        out << path << '\0';
+    }else{
+        out << path << '\n';
+    }
+}
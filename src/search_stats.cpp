@@ -0,0 +1,67 @@
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include "search_stats.hpp"
+
+namespace{
+
+constexpr const char* COUNTER_NAMES[] = {
+    "Files visited",
+    "Skipped (size)",
+    "Skipped (binary)",
+    "Skipped (permission)",
+    "Skipped (unreadable)",
+    "Skipped (ignored)",
+    "Skipped (name filter)",
+    "Transcoded (UTF-16)",
+    "Bytes read",
+    "Lines scanned",
+    "Regex invocations",
+    "Matches",
+};
+
+constexpr const char* PHASE_NAMES[] = {
+    "walk",
+    "open+read",
+    "classify",
+    "match",
+    "output",
+};
+
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == static_cast<std::size_t>(StatCounter::Count));
+static_assert(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]) == static_cast<std::size_t>(StatPhase::Count));
+
+double toMs(std::uint64_t ns){
+    return static_cast<double>(ns) / 1e6;
+}
+
+}
+
+std::uint64_t threadCpuNs(){
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec ts;
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000 + static_cast<std::uint64_t>(ts.tv_nsec);
+#else
+    return static_cast<std::uint64_t>(std::clock()) * (1000000000 / CLOCKS_PER_SEC);
+#endif
+}
+
+void SearchStats::print(std::uint64_t totalWallNs) const{
+    std::cout << "\n--- Search Stats ---\n";
+    for(std::size_t i = 0; i < counters.size(); ++i){
+        std::cout << std::left << std::setw(24) << COUNTER_NAMES[i] << counters[i].load(std::memory_order_relaxed) << "\n";
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n" << std::left << std::setw(24) << "Phase" << std::setw(14) << "wall ms" << "cpu ms\n";
+    for(std::size_t i = 0; i < wallTimes.size(); ++i){
+        std::cout << std::left << std::setw(24) << PHASE_NAMES[i]
+                  << std::setw(14) << toMs(wallTimes[i].load(std::memory_order_relaxed))
+                  << toMs(cpuTimes[i].load(std::memory_order_relaxed)) << "\n";
+    }
+    std::cout << std::left << std::setw(24) << "total (elapsed)" << toMs(totalWallNs) << "\n";
+    std::cout << "Phase times are summed over all threads.\n";
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6) << std::right;
+}
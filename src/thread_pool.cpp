@@ -0,0 +1,110 @@
+#include <algorithm>
+#include "thread_pool.hpp"
+
+WorkStealingPool::WorkStealingPool(std::size_t threadCount){
+    threadCount = std::max<std::size_t>(1, threadCount);
+    workers.reserve(threadCount);
+    for(std::size_t i = 0; i < threadCount; ++i){
+        workers.push_back(std::make_unique<Worker>());
+    }
+    threads.reserve(threadCount);
+    for(std::size_t i = 0; i < threadCount; ++i){
+        threads.emplace_back([this, i]{ run(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool(){
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(sleepMtx);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for(auto &t : threads){
+        if(t.joinable()) t.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task){
+    std::size_t target = nextQueue.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    pending.fetch_add(1, std::memory_order_acq_rel);
+    {
+        std::lock_guard<std::mutex> lock(workers[target]->mtx);
+        workers[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMtx);
+    }
+    workAvailable.notify_one();
+}
+
+void WorkStealingPool::wait(){
+    std::unique_lock<std::mutex> lock(sleepMtx);
+    allDone.wait(lock, [this]{ return pending.load(std::memory_order_acquire) == 0; });
+}
+
+bool WorkStealingPool::popLocal(std::size_t self, Task& out){
+    Worker &w = *workers[self];
+    std::lock_guard<std::mutex> lock(w.mtx);
+    if(w.tasks.empty()) return false;
+    out = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(std::size_t self, Task& out){
+    for(std::size_t offset = 1; offset < workers.size(); ++offset){
+        Worker &victim = *workers[(self + offset) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mtx);
+        if(victim.tasks.empty()) continue;
+        out = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(std::size_t self){
+    Task task;
+    while(true){
+        if(popLocal(self, task) || steal(self, task)){
+            task();
+            task = nullptr;
+            if(pending.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                std::lock_guard<std::mutex> lock(sleepMtx);
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMtx);
+        if(stopping) return;
+        // Re-check under the sleep lock: submit() takes it before notifying,
+        // so a task queued after our failed scan cannot be missed.
+        bool queued = false;
+        for(const auto &w : workers){
+            std::lock_guard<std::mutex> qlock(w->mtx);
+            if(!w->tasks.empty()){
+                queued = true;
+                break;
+            }
+        }
+        if(queued) continue;
+        workAvailable.wait(lock);
+    }
+}
+
+void parallelFor(WorkStealingPool& pool, std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& fn){
+    if(count == 0) return;
+    std::size_t chunks = std::min(count / std::max<std::size_t>(1, grain), pool.size() * 4);
+    if(chunks <= 1){
+        fn(0, count);
+        return;
+    }
+    std::size_t step = (count + chunks - 1) / chunks;
+    for(std::size_t begin = 0; begin < count; begin += step){
+        std::size_t end = std::min(count, begin + step);
+        pool.submit([&fn, begin, end]{ fn(begin, end); });
+    }
+    pool.wait();
+}
@@ -0,0 +1,271 @@
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include "tree_snapshot.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#define TREE_SNAPSHOT_POSIX 1
+#endif
+
+namespace{
+
+constexpr std::uint32_t NO_SLOT = UINT32_MAX;
+// Directories per parallel chunk when reading or checking a snapshot.
+constexpr std::size_t SNAPSHOT_PARALLEL_GRAIN = 16;
+
+// One directory's entries, read ahead of being appended to the snapshot.
+// `entries` holds each name's end offset in `names` and its type.
+struct Listing{
+    std::string names;
+    std::vector<std::pair<std::uint32_t, EntryType>> entries;
+    std::int64_t mtime = -1;
+    FileError result = FileError::Ok;
+};
+
+std::mutex cacheMtx;
+std::unordered_map<std::string, std::shared_ptr<const TreeSnapshot>> cache;
+
+std::int64_t dirMtime(const std::string& path){
+#ifdef TREE_SNAPSHOT_POSIX
+    struct stat st;
+    if(::stat(path.c_str(), &st) != 0) return -1;
+#ifdef __APPLE__
+    return static_cast<std::int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    return static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#else
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(path, ec);
+    if(ec) return -1;
+    return static_cast<std::int64_t>(time.time_since_epoch().count());
+#endif
+}
+
+std::filesystem::path normalized(const std::filesystem::path& path){
+    std::error_code ec;
+    std::filesystem::path abs = std::filesystem::absolute(path, ec);
+    if(ec) abs = path;
+    abs = abs.lexically_normal();
+    if(!abs.has_filename() && abs.has_parent_path() && abs != abs.root_path()) abs = abs.parent_path();
+    return abs;
+}
+
+}
+
+std::string_view TreeSnapshot::name(std::uint32_t id) const{
+    return std::string_view(namePool).substr(nameOffsets[id], nameOffsets[id + 1] - nameOffsets[id]);
+}
+
+std::string_view TreeSnapshot::pathOf(std::uint32_t entry, Arena& arena) const{
+    const std::string &root = rootPath.native();
+    bool rootSeparator = !root.empty() && root.back() != '/';
+
+    // Measure first, then fill in from the end while walking up the parents.
+    std::size_t size = root.size();
+    std::size_t parts = 0;
+    for(std::uint32_t at = entry; at != 0 && at != NO_PARENT; at = parents[at]){
+        size += name(nameIds[at]).size();
+        ++parts;
+    }
+    if(parts == 0) return arena.copy(root);
+    size += parts - 1 + rootSeparator;
+
+    char *out = static_cast<char*>(arena.allocate(size + 1, 1));
+    out[size] = '\0';
+    std::size_t end = size;
+    for(std::uint32_t at = entry; at != 0 && at != NO_PARENT; at = parents[at]){
+        std::string_view part = name(nameIds[at]);
+        end -= part.size();
+        std::memcpy(out + end, part.data(), part.size());
+        if(end > root.size()) out[--end] = '/';
+    }
+    std::memcpy(out, root.data(), root.size());
+    return {out, size};
+}
+
+std::pair<std::uint32_t, std::uint32_t> TreeSnapshot::children(std::uint32_t entry) const{
+    std::uint32_t slot = dirSlot[entry];
+    if(slot == NO_SLOT) return {0, 0};
+    return {childBegin[slot], childEnd[slot]};
+}
+
+std::uint32_t TreeSnapshot::lookup(const std::filesystem::path& path) const{
+    std::filesystem::path rel = normalized(path).lexically_relative(normalized(rootPath));
+    if(rel.empty()) return NO_PARENT;
+
+    std::uint32_t at = 0;
+    for(const auto &part : rel){
+        std::string component = part.string();
+        if(component.empty() || component == ".") continue;
+        if(component == "..") return NO_PARENT;
+
+        auto [first, last] = children(at);
+        std::uint32_t next = NO_PARENT;
+        for(std::uint32_t child = first; child < last; ++child){
+            if(name(nameIds[child]) == component){
+                next = child;
+                break;
+            }
+        }
+        if(next == NO_PARENT) return NO_PARENT;
+        at = next;
+    }
+    return at;
+}
+
+bool TreeSnapshot::isCurrent(WorkStealingPool* pool) const{
+    std::atomic<bool> current{true};
+    auto check = [&](std::size_t first, std::size_t last){
+        for(std::size_t slot = first; slot < last && current.load(std::memory_order_relaxed); ++slot){
+            if(dirMtime(dirPaths[slot]) != dirMtimes[slot]) current.store(false, std::memory_order_relaxed);
+        }
+    };
+    if(pool){
+        parallelFor(*pool, dirPaths.size(), SNAPSHOT_PARALLEL_GRAIN, check);
+    }else{
+        check(0, dirPaths.size());
+    }
+    return current.load();
+}
+
+bool TreeSnapshot::isCurrent(std::uint32_t entry) const{
+    std::uint32_t slot = dirSlot[entry];
+    if(slot == NO_SLOT) return false;
+    return dirMtime(dirPaths[slot]) == dirMtimes[slot];
+}
+
+std::pair<std::shared_ptr<const TreeSnapshot>, FileError> buildSnapshot(const std::filesystem::path& root, WorkStealingPool* pool){
+    std::error_code ec;
+    if(!std::filesystem::exists(root, ec)) return {nullptr, ec ? FileError::UnknownError : FileError::PathNotFound};
+    if(!std::filesystem::is_directory(root, ec)) return {nullptr, ec ? FileError::UnknownError : FileError::NotADirectory};
+
+    auto snapshot = std::make_shared<TreeSnapshot>();
+    TreeSnapshot &tree = *snapshot;
+    tree.rootPath = root;
+
+    std::unordered_map<std::string, std::uint32_t> interned;
+    auto intern = [&](std::string_view name){
+        auto [it, inserted] = interned.try_emplace(std::string(name), static_cast<std::uint32_t>(tree.nameOffsets.size() - 1));
+        if(inserted){
+            tree.namePool.append(name.data(), name.size());
+            tree.nameOffsets.push_back(static_cast<std::uint32_t>(tree.namePool.size()));
+        }
+        return it->second;
+    };
+
+    tree.nameIds.push_back(intern(""));
+    tree.parents.push_back(TreeSnapshot::NO_PARENT);
+    tree.types.push_back(EntryType::Directory);
+    tree.dirSlot.push_back(0);
+    tree.dirPaths.push_back(root.string());
+    tree.dirMtimes.push_back(0);
+    tree.childBegin.push_back(0);
+    tree.childEnd.push_back(0);
+
+    // Entries are appended breadth-first, so every directory's children
+    // land in one contiguous range. One depth level is read at a time; its
+    // listings are gathered (in parallel with a pool) and then appended in
+    // entry order.
+    std::vector<std::uint32_t> level{0};
+    std::vector<Listing> listings;
+    while(!level.empty()){
+        listings.clear();
+        listings.resize(level.size());
+        auto readRange = [&](std::size_t first, std::size_t last){
+            for(std::size_t i = first; i < last; ++i){
+                const std::string &path = tree.dirPaths[tree.dirSlot[level[i]]];
+                Listing &out = listings[i];
+                out.mtime = dirMtime(path);
+                out.result = listDirectory(path, [&out](std::string_view name, EntryType type){
+                    out.names.append(name.data(), name.size());
+                    out.entries.emplace_back(static_cast<std::uint32_t>(out.names.size()), type);
+                });
+            }
+        };
+        if(pool){
+            parallelFor(*pool, level.size(), SNAPSHOT_PARALLEL_GRAIN, readRange);
+        }else{
+            readRange(0, level.size());
+        }
+
+        std::vector<std::uint32_t> next;
+        for(std::size_t i = 0; i < level.size(); ++i){
+            std::uint32_t entry = level[i];
+            std::uint32_t slot = tree.dirSlot[entry];
+            const Listing &listing = listings[i];
+            if(listing.result != FileError::Ok && entry == 0) return {nullptr, listing.result};
+
+            tree.dirMtimes[slot] = listing.mtime;
+            tree.childBegin[slot] = static_cast<std::uint32_t>(tree.types.size());
+            std::uint32_t nameStart = 0;
+            for(const auto &[nameEnd, type] : listing.entries){
+                std::string_view name = std::string_view(listing.names).substr(nameStart, nameEnd - nameStart);
+                nameStart = nameEnd;
+                if(type == EntryType::Directory){
+                    next.push_back(static_cast<std::uint32_t>(tree.types.size()));
+                    tree.dirSlot.push_back(static_cast<std::uint32_t>(tree.dirPaths.size()));
+                    tree.dirPaths.push_back(joinPath(tree.dirPaths[slot], name));
+                    tree.dirMtimes.push_back(0);
+                    tree.childBegin.push_back(0);
+                    tree.childEnd.push_back(0);
+                }else{
+                    tree.dirSlot.push_back(NO_SLOT);
+                }
+                tree.nameIds.push_back(intern(name));
+                tree.parents.push_back(entry);
+                tree.types.push_back(type);
+            }
+            tree.childEnd[slot] = static_cast<std::uint32_t>(tree.types.size());
+        }
+        level.swap(next);
+    }
+    return {snapshot, FileError::Ok};
+}
+
+std::pair<std::shared_ptr<const TreeSnapshot>, FileError> snapshotFor(const std::filesystem::path& root, std::size_t threads, bool trusted){
+    std::unique_ptr<WorkStealingPool> pool;
+    if(threads > 1) pool = std::make_unique<WorkStealingPool>(threads);
+
+    std::lock_guard<std::mutex> lock(cacheMtx);
+    auto cached = cache.find(root.string());
+    if(cached != cache.end() && (trusted || cached->second->isCurrent(pool.get()))) return {cached->second, FileError::Ok};
+
+    auto [snapshot, err] = buildSnapshot(root, pool.get());
+    if(err != FileError::Ok){
+        if(cached != cache.end()) cache.erase(cached);
+        return {nullptr, err};
+    }
+    cache[root.string()] = snapshot;
+    return {snapshot, FileError::Ok};
+}
+
+std::shared_ptr<const TreeSnapshot> cachedSnapshotContaining(const std::filesystem::path& path, std::uint32_t& entry){
+    std::lock_guard<std::mutex> lock(cacheMtx);
+    for(const auto &[root, snapshot] : cache){
+        std::uint32_t found = snapshot->lookup(path);
+        if(found == TreeSnapshot::NO_PARENT) continue;
+        entry = found;
+        return snapshot;
+    }
+    return nullptr;
+}
+
+void dropSnapshots(const std::filesystem::path& path){
+    std::string changed = normalized(path).string();
+    auto within = [](const std::string& inner, const std::string& outer){
+        return inner.compare(0, outer.size(), outer) == 0 &&
+               (inner.size() == outer.size() || outer.back() == '/' || inner[outer.size()] == '/');
+    };
+    std::lock_guard<std::mutex> lock(cacheMtx);
+    for(auto it = cache.begin(); it != cache.end();){
+        std::string root = normalized(it->second->root()).string();
+        if(within(changed, root) || within(root, changed)){
+            it = cache.erase(it);
+        }else{
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,668 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <unordered_set>
+#include "file_reader.hpp"
+#include "literal_scan.hpp"
+#include "content_type.hpp"
+#include "ignore_rules.hpp"
+#include "thread_pool.hpp"
+#include "trigram_index.hpp"
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+namespace{
+
+constexpr char INDEX_MAGIC[8] = {'F', 'C', 'I', 'D', 'X', '1', '\0', '\0'};
+constexpr std::size_t INDEX_BATCH_SIZE = 1024;
+
+struct FileStat{
+    bool exists = false;
+    bool isDir = false;
+    bool isRegular = false;
+    std::int64_t mtime = 0;
+    std::uint64_t size = 0;
+};
+
+FileStat statPath(const std::filesystem::path& path){
+    FileStat out;
+#ifdef __linux__
+    struct stat st;
+    if(::stat(path.c_str(), &st) != 0) return out;
+    out.exists = true;
+    out.isDir = S_ISDIR(st.st_mode);
+    out.isRegular = S_ISREG(st.st_mode);
+    out.mtime = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    out.size = static_cast<std::uint64_t>(st.st_size);
+#else
+    std::error_code ec;
+    auto status = std::filesystem::status(path, ec);
+    if(ec || !std::filesystem::exists(status)) return out;
+    out.exists = true;
+    out.isDir = std::filesystem::is_directory(status);
+    out.isRegular = std::filesystem::is_regular_file(status);
+    out.mtime = static_cast<std::int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+    if(out.isRegular) out.size = std::filesystem::file_size(path, ec);
+#endif
+    return out;
+}
+
+// Distinct trigrams of `text`, skipping any that span a newline since
+// patterns are matched one line at a time.
+void collectTrigrams(std::string_view text, std::vector<std::uint32_t>& out){
+    thread_local std::vector<std::uint64_t> seen(std::size_t(1) << 18, 0);
+    out.clear();
+    for(std::size_t i = 0; i + 3 <= text.size(); ++i){
+        unsigned char a = static_cast<unsigned char>(text[i]);
+        unsigned char b = static_cast<unsigned char>(text[i + 1]);
+        unsigned char c = static_cast<unsigned char>(text[i + 2]);
+        if(a == '\n' || b == '\n' || c == '\n') continue;
+        std::uint32_t tri = packTrigram(a, b, c);
+        std::uint64_t bit = std::uint64_t(1) << (tri & 63);
+        if(seen[tri >> 6] & bit) continue;
+        seen[tri >> 6] |= bit;
+        out.push_back(tri);
+    }
+    for(std::uint32_t tri : out) seen[tri >> 6] = 0;
+}
+
+void putU32(std::string& out, std::uint32_t v){
+    for(int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void putU64(std::string& out, std::uint64_t v){
+    for(int i = 0; i < 8; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void putString(std::string& out, const std::string& s){
+    putU32(out, static_cast<std::uint32_t>(s.size()));
+    out += s;
+}
+
+void putVarint(std::string& out, std::uint32_t v){
+    while(v >= 0x80){
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+class Reader{
+public:
+    explicit Reader(std::string_view data) : data(data) {}
+
+    bool u32(std::uint32_t& v){
+        if(pos + 4 > data.size()) return false;
+        v = 0;
+        for(int i = 0; i < 4; ++i) v |= static_cast<std::uint32_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+        pos += 4;
+        return true;
+    }
+
+    bool u8(unsigned char& v){
+        if(pos >= data.size()) return false;
+        v = static_cast<unsigned char>(data[pos++]);
+        return true;
+    }
+
+    bool u64(std::uint64_t& v){
+        if(pos + 8 > data.size()) return false;
+        v = 0;
+        for(int i = 0; i < 8; ++i) v |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+        pos += 8;
+        return true;
+    }
+
+    bool bytes(std::string& out){
+        std::uint32_t len = 0;
+        if(!u32(len) || pos + len > data.size()) return false;
+        out.assign(data.data() + pos, len);
+        pos += len;
+        return true;
+    }
+
+    bool skip(std::size_t n){
+        if(pos + n > data.size()) return false;
+        pos += n;
+        return true;
+    }
+
+private:
+    std::string_view data;
+    std::size_t pos = 0;
+};
+
+std::vector<std::uint32_t> decodePostings(const std::string& encoded){
+    std::vector<std::uint32_t> ids;
+    std::uint32_t current = 0;
+    std::uint32_t value = 0;
+    int shift = 0;
+    for(char ch : encoded){
+        unsigned char byte = static_cast<unsigned char>(ch);
+        value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+        if(byte & 0x80){
+            shift += 7;
+            continue;
+        }
+        current += value;
+        ids.push_back(current);
+        value = 0;
+        shift = 0;
+    }
+    return ids;
+}
+
+std::string relativePath(const std::filesystem::path& path, const std::filesystem::path& root){
+    return path.lexically_relative(root).generic_string();
+}
+
+// Ignore scope of `rel`, a directory below the index root, built down from
+// the root so that the root's own ignore files apply. Null if `rel` or a
+// directory above it is ignored.
+std::shared_ptr<const IgnoreScope> scopeBelow(const std::filesystem::path& root, const std::string& rel){
+    std::shared_ptr<const IgnoreScope> scope = ignoreScopeFor(root);
+    std::filesystem::path dir = root;
+    for(const auto &part : std::filesystem::path(rel)){
+        std::string name = part.string();
+        if(scope->ignored(name, true)) return nullptr;
+        dir /= part;
+        scope = scope->child(name, dir.native());
+    }
+    return scope;
+}
+
+// Walks the tree below `dir`, whose ignore rules are `scope`, as a search
+// would: `.git` and ignored entries are left out, and ignored directories
+// are not entered. `visit` gets each entry and whether it is a directory.
+// False on an error other than a permission denied.
+template<typename Visit>
+bool walkIndexable(const std::filesystem::path& dir, std::shared_ptr<const IgnoreScope> scope, Visit visit){
+    // scopes[d] holds the ignore rules for entries at depth d.
+    std::vector<std::shared_ptr<const IgnoreScope>> scopes{std::move(scope)};
+    std::error_code ec;
+    for(std::filesystem::recursive_directory_iterator it(dir, std::filesystem::directory_options::skip_permission_denied, ec);
+        it != std::filesystem::recursive_directory_iterator(); it.increment(ec)){
+        if(ec){
+            if(ec == std::errc::permission_denied){
+                ec.clear();
+                continue;
+            }
+            return false;
+        }
+
+        const std::filesystem::directory_entry &entry = *it;
+        std::size_t depth = static_cast<std::size_t>(it.depth());
+        std::error_code stat_ec;
+        bool isDir = entry.is_directory(stat_ec) && !entry.is_symlink(stat_ec);
+        std::string name = entry.path().filename().string();
+        if(scopes[depth]->ignored(name, isDir)){
+            if(isDir) it.disable_recursion_pending();
+            continue;
+        }
+        if(isDir){
+            auto scope = scopes[depth]->child(name, entry.path().native());
+            scopes.resize(depth + 1);
+            scopes.push_back(std::move(scope));
+        }
+        visit(entry, isDir);
+    }
+    return true;
+}
+
+bool withinDepth(const std::string& rel, const SearchConfig& config){
+    if(config.maxDepth < 0) return true;
+    auto slashes = std::count(rel.begin(), rel.end(), '/');
+    return slashes <= config.maxDepth + 1;
+}
+
+}
+
+std::pair<TrigramIndex, FileError> buildIndex(const std::filesystem::path& root){
+    TrigramIndex index;
+    std::error_code ec;
+    if(!std::filesystem::exists(root, ec)) return {std::move(index), ec ? FileError::UnknownError : FileError::PathNotFound};
+    if(!std::filesystem::is_directory(root, ec)) return {std::move(index), ec ? FileError::UnknownError : FileError::NotADirectory};
+
+    index.root = std::filesystem::absolute(root, ec).lexically_normal();
+    index.dirs.push_back({"", statPath(index.root).mtime});
+
+    bool walked = walkIndexable(index.root, ignoreScopeFor(index.root), [&index](const std::filesystem::directory_entry& entry, bool isDir){
+        std::string rel = relativePath(entry.path(), index.root);
+        if(isDir){
+            index.dirs.push_back({std::move(rel), statPath(entry.path()).mtime});
+            return;
+        }
+        std::error_code stat_ec;
+        if(!entry.is_regular_file(stat_ec) || rel == INDEX_FILE_NAME) return;
+
+        FileStat st = statPath(entry.path());
+        index.files.push_back({std::move(rel), st.mtime, st.size, false});
+    });
+    if(!walked) return {std::move(index), FileError::UnknownError};
+
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> lists;
+    std::vector<std::vector<std::uint32_t>> batch(INDEX_BATCH_SIZE);
+    WorkStealingPool pool(defaultThreadCount());
+
+    for(std::size_t base = 0; base < index.files.size(); base += INDEX_BATCH_SIZE){
+        std::size_t count = std::min(INDEX_BATCH_SIZE, index.files.size() - base);
+        for(std::size_t i = 0; i < count; ++i){
+            pool.submit([&index, &batch, base, i]{
+                IndexedFile &file = index.files[base + i];
+                batch[i].clear();
+                auto [buffer, err] = readWholeFile((index.root / file.path).c_str());
+                if(err != FileError::Ok){
+                    file.binary = true;
+                    return;
+                }
+                ContentKind kind = classifyContent(buffer.view());
+                if(kind == ContentKind::Binary){
+                    file.binary = true;
+                    return;
+                }
+                collectTrigrams(searchableText(buffer.view(), kind), batch[i]);
+            });
+        }
+        pool.wait();
+
+        for(std::size_t i = 0; i < count; ++i){
+            for(std::uint32_t tri : batch[i]) lists[tri].push_back(static_cast<std::uint32_t>(base + i));
+        }
+    }
+
+    for(auto &[tri, ids] : lists){
+        std::string encoded;
+        std::uint32_t prev = 0;
+        for(std::uint32_t id : ids){
+            putVarint(encoded, id - prev);
+            prev = id;
+        }
+        index.postings.emplace(tri, std::move(encoded));
+    }
+    return {std::move(index), FileError::Ok};
+}
+
+FileError saveIndex(const TrigramIndex& index){
+    if(index.deletedCount != 0){
+        TrigramIndex compacted = index;
+        compactIndex(compacted);
+        return saveIndex(compacted);
+    }
+
+    std::string out(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+
+    putU32(out, static_cast<std::uint32_t>(index.files.size()));
+    for(const auto &file : index.files){
+        putString(out, file.path);
+        putU64(out, static_cast<std::uint64_t>(file.mtime));
+        putU64(out, file.size);
+        out.push_back(file.binary ? '\1' : '\0');
+    }
+
+    putU32(out, static_cast<std::uint32_t>(index.dirs.size()));
+    for(const auto &dir : index.dirs){
+        putString(out, dir.path);
+        putU64(out, static_cast<std::uint64_t>(dir.mtime));
+    }
+
+    putU32(out, static_cast<std::uint32_t>(index.postings.size()));
+    for(const auto &[tri, encoded] : index.postings){
+        putU32(out, tri);
+        putString(out, encoded);
+    }
+
+    std::filesystem::path target = index.root / INDEX_FILE_NAME;
+    std::filesystem::path temp = target;
+    temp += ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if(!file) return FileError::WriteFailure;
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if(!file) return FileError::WriteFailure;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp, target, ec);
+    if(ec) return FileError::WriteFailure;
+    return FileError::Ok;
+}
+
+std::pair<TrigramIndex, FileError> loadIndex(const std::filesystem::path& root){
+    TrigramIndex index;
+    std::error_code ec;
+    index.root = std::filesystem::absolute(root, ec).lexically_normal();
+
+    auto [buffer, err] = readWholeFile((index.root / INDEX_FILE_NAME).c_str());
+    if(err != FileError::Ok) return {std::move(index), err};
+
+    std::string_view data = buffer.view();
+    if(data.size() < sizeof(INDEX_MAGIC) || std::memcmp(data.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0){
+        return {std::move(index), FileError::ReadFailure};
+    }
+    Reader in(data);
+    in.skip(sizeof(INDEX_MAGIC));
+
+    std::uint32_t fileCount = 0;
+    if(!in.u32(fileCount)) return {std::move(index), FileError::ReadFailure};
+    index.files.resize(fileCount);
+    for(auto &file : index.files){
+        std::uint64_t mtime = 0;
+        unsigned char binary = 0;
+        if(!in.bytes(file.path) || !in.u64(mtime) || !in.u64(file.size) || !in.u8(binary)){
+            return {std::move(index), FileError::ReadFailure};
+        }
+        file.mtime = static_cast<std::int64_t>(mtime);
+        file.binary = binary != 0;
+    }
+
+    std::uint32_t dirCount = 0;
+    if(!in.u32(dirCount)) return {std::move(index), FileError::ReadFailure};
+    index.dirs.resize(dirCount);
+    for(auto &dir : index.dirs){
+        std::uint64_t mtime = 0;
+        if(!in.bytes(dir.path) || !in.u64(mtime)) return {std::move(index), FileError::ReadFailure};
+        dir.mtime = static_cast<std::int64_t>(mtime);
+    }
+
+    std::uint32_t trigramCount = 0;
+    if(!in.u32(trigramCount)) return {std::move(index), FileError::ReadFailure};
+    index.postings.reserve(trigramCount);
+    for(std::uint32_t i = 0; i < trigramCount; ++i){
+        std::uint32_t tri = 0;
+        std::string encoded;
+        if(!in.u32(tri) || !in.bytes(encoded)) return {std::move(index), FileError::ReadFailure};
+        index.postings.emplace(tri, std::move(encoded));
+    }
+    return {std::move(index), FileError::Ok};
+}
+
+std::pair<std::shared_ptr<const TrigramIndex>, FileError> loadSharedIndex(const std::filesystem::path& root){
+    struct Loaded{
+        std::int64_t mtime = 0;
+        std::uint64_t size = 0;
+        std::shared_ptr<const TrigramIndex> index;
+    };
+    static std::mutex loadedMtx;
+    static std::unordered_map<std::string, Loaded> loaded;
+
+    std::error_code ec;
+    std::filesystem::path normalized = std::filesystem::absolute(root, ec).lexically_normal();
+    FileStat st = statPath(normalized / INDEX_FILE_NAME);
+
+    std::lock_guard<std::mutex> lock(loadedMtx);
+    auto found = loaded.find(normalized.string());
+    if(found != loaded.end() && st.exists && found->second.mtime == st.mtime && found->second.size == st.size){
+        return {found->second.index, FileError::Ok};
+    }
+
+    auto [index, err] = loadIndex(normalized);
+    if(err != FileError::Ok){
+        if(found != loaded.end()) loaded.erase(found);
+        return {nullptr, err};
+    }
+    Loaded entry{st.mtime, st.size, std::make_shared<const TrigramIndex>(std::move(index))};
+    loaded[normalized.string()] = entry;
+    return {entry.index, FileError::Ok};
+}
+
+std::vector<std::filesystem::path> indexCandidates(const TrigramIndex& index, const std::vector<std::uint32_t>& trigrams, const SearchConfig& config,
+                                                   const std::string& prefix, bool verifyFreshness){
+    std::vector<char> matchesTrigrams(index.files.size(), trigrams.empty() ? 1 : 0);
+    if(!trigrams.empty()){
+        std::vector<std::vector<std::uint32_t>> lists;
+        bool missing = false;
+        for(std::uint32_t tri : trigrams){
+            auto it = index.postings.find(tri);
+            if(it == index.postings.end()){
+                missing = true;
+                break;
+            }
+            lists.push_back(decodePostings(it->second));
+        }
+
+        if(!missing){
+            std::sort(lists.begin(), lists.end(), [](const auto &a, const auto &b){ return a.size() < b.size(); });
+            std::vector<std::uint32_t> current = std::move(lists.front());
+            std::vector<std::uint32_t> next;
+            for(std::size_t i = 1; i < lists.size() && !current.empty(); ++i){
+                next.clear();
+                std::set_intersection(current.begin(), current.end(), lists[i].begin(), lists[i].end(), std::back_inserter(next));
+                current.swap(next);
+            }
+            for(std::uint32_t id : current){
+                if(id < matchesTrigrams.size()) matchesTrigrams[id] = 1;
+            }
+        }
+    }
+
+    const std::string scope = prefix.empty() ? prefix : prefix + "/";
+    std::vector<std::filesystem::path> candidates;
+    auto consider = [&](const std::string& rel, std::uint64_t size){
+        if(rel.compare(0, scope.size(), scope) != 0) return;
+        if(size > config.maxFileSize || !withinDepth(rel.substr(scope.size()), config)) return;
+        candidates.push_back(index.root / rel);
+    };
+
+    if(!verifyFreshness){
+        for(std::size_t i = 0; i < index.files.size(); ++i){
+            const IndexedFile &file = index.files[i];
+            if(!file.deleted && !file.binary && matchesTrigrams[i]) consider(file.path, file.size);
+        }
+        return candidates;
+    }
+
+    std::unordered_set<std::string> knownFiles;
+    knownFiles.reserve(index.files.size());
+    for(std::size_t i = 0; i < index.files.size(); ++i){
+        const IndexedFile &file = index.files[i];
+        if(file.deleted) continue;
+        knownFiles.insert(file.path);
+        if(file.path.compare(0, scope.size(), scope) != 0) continue;
+
+        FileStat st = statPath(index.root / file.path);
+        if(!st.exists || !st.isRegular) continue;
+        bool stale = st.mtime != file.mtime || st.size != file.size;
+        if(stale || (matchesTrigrams[i] && !file.binary)) consider(file.path, st.size);
+    }
+
+    // A changed directory mtime means entries were added or removed there;
+    // anything the index has never seen is scanned directly.
+    std::unordered_set<std::string> knownDirs;
+    for(const auto &dir : index.dirs) knownDirs.insert(dir.path);
+
+    for(const auto &dir : index.dirs){
+        FileStat st = statPath(index.root / dir.path);
+        if(!st.exists || st.mtime == dir.mtime) continue;
+
+        std::shared_ptr<const IgnoreScope> scope = scopeBelow(index.root, dir.path);
+        if(!scope) continue;
+        std::error_code ec;
+        for(std::filesystem::directory_iterator it(index.root / dir.path, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec)){
+            std::string rel = relativePath(it->path(), index.root);
+            std::error_code stat_ec;
+            if(it->is_regular_file(stat_ec)){
+                if(dir.path.empty() && it->path().filename() == INDEX_FILE_NAME) continue;
+                if(!knownFiles.count(rel)) consider(rel, it->file_size(stat_ec));
+                continue;
+            }
+            if(!it->is_directory(stat_ec) || it->is_symlink(stat_ec) || knownDirs.count(rel)) continue;
+            // The build left ignored directories out; they are not new.
+            std::string name = it->path().filename().string();
+            if(scope->ignored(name, true)) continue;
+
+            (void)walkIndexable(it->path(), scope->child(name, it->path().native()), [&](const std::filesystem::directory_entry& entry, bool isDir){
+                std::error_code sub_ec;
+                if(!isDir && entry.is_regular_file(sub_ec)) consider(relativePath(entry.path(), index.root), entry.file_size(sub_ec));
+            });
+        }
+    }
+    return candidates;
+}
+
+static void ensureLookup(TrigramIndex& index){
+    if(!index.fileIds.empty() || index.files.empty()) return;
+    index.fileIds.reserve(index.files.size());
+    for(std::size_t i = 0; i < index.files.size(); ++i){
+        if(!index.files[i].deleted) index.fileIds[index.files[i].path] = static_cast<std::uint32_t>(i);
+    }
+}
+
+static void tombstone(TrigramIndex& index, std::uint32_t id){
+    if(index.files[id].deleted) return;
+    index.files[id].deleted = true;
+    ++index.deletedCount;
+    index.fileIds.erase(index.files[id].path);
+}
+
+static std::uint32_t postingTail(TrigramIndex& index, std::uint32_t tri, const std::string& encoded){
+    auto cached = index.postingTails.find(tri);
+    if(cached != index.postingTails.end()) return cached->second;
+    std::vector<std::uint32_t> ids = decodePostings(encoded);
+    return ids.empty() ? 0 : ids.back();
+}
+
+void updateIndexedFile(TrigramIndex& index, const std::string& rel){
+    ensureLookup(index);
+    FileStat st = statPath(index.root / rel);
+    if(!st.exists || !st.isRegular){
+        removeIndexedPath(index, rel);
+        return;
+    }
+
+    auto existing = index.fileIds.find(rel);
+    if(existing != index.fileIds.end()){
+        const IndexedFile &file = index.files[existing->second];
+        if(file.mtime == st.mtime && file.size == st.size) return;
+        tombstone(index, existing->second);
+    }
+
+    std::uint32_t id = static_cast<std::uint32_t>(index.files.size());
+    index.files.push_back({rel, st.mtime, st.size, false, false});
+    index.fileIds[rel] = id;
+
+    auto [buffer, err] = readWholeFile((index.root / rel).c_str());
+    ContentKind kind = err == FileError::Ok ? classifyContent(buffer.view()) : ContentKind::Binary;
+    if(kind == ContentKind::Binary){
+        index.files[id].binary = true;
+        return;
+    }
+
+    std::vector<std::uint32_t> trigrams;
+    collectTrigrams(searchableText(buffer.view(), kind), trigrams);
+    for(std::uint32_t tri : trigrams){
+        std::string &encoded = index.postings[tri];
+        std::uint32_t tail = encoded.empty() ? 0 : postingTail(index, tri, encoded);
+        putVarint(encoded, id - tail);
+        index.postingTails[tri] = id;
+    }
+}
+
+void removeIndexedPath(TrigramIndex& index, const std::string& rel){
+    ensureLookup(index);
+    auto it = index.fileIds.find(rel);
+    if(it != index.fileIds.end()){
+        tombstone(index, it->second);
+        return;
+    }
+
+    const std::string prefix = rel + "/";
+    for(std::size_t i = 0; i < index.files.size(); ++i){
+        if(!index.files[i].deleted && index.files[i].path.compare(0, prefix.size(), prefix) == 0){
+            tombstone(index, static_cast<std::uint32_t>(i));
+        }
+    }
+    index.dirs.erase(std::remove_if(index.dirs.begin(), index.dirs.end(), [&](const IndexedDir &dir){
+        return dir.path == rel || dir.path.compare(0, prefix.size(), prefix) == 0;
+    }), index.dirs.end());
+}
+
+void addIndexedTree(TrigramIndex& index, const std::string& rel){
+    std::filesystem::path dirPath = index.root / rel;
+    auto known = [&](const std::string& dir){
+        return std::any_of(index.dirs.begin(), index.dirs.end(), [&](const IndexedDir &d){ return d.path == dir; });
+    };
+    std::shared_ptr<const IgnoreScope> scope = scopeBelow(index.root, rel);
+    if(!scope) return;
+    if(!known(rel)) index.dirs.push_back({rel, statPath(dirPath).mtime});
+
+    (void)walkIndexable(dirPath, std::move(scope), [&](const std::filesystem::directory_entry& entry, bool isDir){
+        std::string entryRel = relativePath(entry.path(), index.root);
+        if(isDir){
+            if(!known(entryRel)) index.dirs.push_back({entryRel, statPath(entry.path()).mtime});
+            return;
+        }
+        std::error_code stat_ec;
+        if(!entry.is_regular_file(stat_ec) || entryRel == INDEX_FILE_NAME) return;
+        updateIndexedFile(index, entryRel);
+    });
+}
+
+void refreshIndex(TrigramIndex& index){
+    ensureLookup(index);
+    std::size_t liveCount = index.files.size();
+    for(std::size_t i = 0; i < liveCount; ++i){
+        if(index.files[i].deleted) continue;
+        std::string rel = index.files[i].path;
+        updateIndexedFile(index, rel);
+    }
+
+    std::vector<IndexedDir> dirs = index.dirs;
+    for(auto &dir : dirs){
+        FileStat st = statPath(index.root / dir.path);
+        if(!st.exists){
+            removeIndexedPath(index, dir.path);
+            continue;
+        }
+        if(st.mtime == dir.mtime) continue;
+        addIndexedTree(index, dir.path);
+    }
+    refreshDirTimes(index);
+}
+
+void refreshDirTimes(TrigramIndex& index){
+    for(auto &dir : index.dirs) dir.mtime = statPath(index.root / dir.path).mtime;
+}
+
+void compactIndex(TrigramIndex& index){
+    if(index.deletedCount == 0) return;
+
+    std::vector<std::uint32_t> remap(index.files.size(), UINT32_MAX);
+    std::vector<IndexedFile> live;
+    live.reserve(index.files.size() - index.deletedCount);
+    for(std::size_t i = 0; i < index.files.size(); ++i){
+        if(index.files[i].deleted) continue;
+        remap[i] = static_cast<std::uint32_t>(live.size());
+        live.push_back(std::move(index.files[i]));
+    }
+
+    std::unordered_map<std::uint32_t, std::string> postings;
+    postings.reserve(index.postings.size());
+    for(const auto &[tri, encoded] : index.postings){
+        std::string rewritten;
+        std::uint32_t prev = 0;
+        for(std::uint32_t id : decodePostings(encoded)){
+            if(remap[id] == UINT32_MAX) continue;
+            putVarint(rewritten, remap[id] - prev);
+            prev = remap[id];
+        }
+        if(!rewritten.empty()) postings.emplace(tri, std::move(rewritten));
+    }
+
+    index.files = std::move(live);
+    index.postings = std::move(postings);
+    index.fileIds.clear();
+    index.postingTails.clear();
+    index.deletedCount = 0;
+}
+
+bool indexRelativePath(const TrigramIndex& index, const std::filesystem::path& path, std::string& rel){
+    std::error_code ec;
+    std::filesystem::path absolute = std::filesystem::absolute(path, ec).lexically_normal();
+    if(ec) return false;
+    rel = absolute.lexically_relative(index.root).generic_string();
+    if(rel == ".") rel.clear();
+    return rel.compare(0, 2, "..") != 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+// Shared by the test programs: a failed check prints where it failed and
+// what was compared, and main returns testResult().
+inline int& testFailures(){
+    static int failures = 0;
+    return failures;
+}
+
+inline int testResult(const char* name){
+    if(testFailures() == 0){
+        std::cout << "[PASS] " << name << "\n";
+        return 0;
+    }
+    std::cout << "[FAIL] " << name << ": " << testFailures() << " failed\n";
+    return 1;
+}
+
+inline void checkThat(bool ok, const std::string& what, const char* file, int line){
+    if(ok) return;
+    ++testFailures();
+    std::cout << file << ":" << line << ": " << what << "\n";
+}
+
+template<typename A, typename B>
+void checkEqual(const A& actual, const B& expected, const std::string& what, const char* file, int line){
+    if(actual == expected) return;
+    ++testFailures();
+    std::cout << file << ":" << line << ": " << what << ": got " << actual << ", expected " << expected << "\n";
+}
+
+#define CHECK(cond) checkThat((cond), #cond, __FILE__, __LINE__)
+#define CHECK_EQ(actual, expected, what) checkEqual((actual), (expected), (what), __FILE__, __LINE__)
@@ -0,0 +1,76 @@
+#include <iterator>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "dfa_matcher.hpp"
+
+// Differential test: the DFA engine must agree with std::regex, which it
+// stands in for, on search() and on every span find() reports.
+namespace{
+
+const char* PATTERNS[] = {
+    "a", "ab", "a|ab", "foo|foobar", "ab|a", "a+", "a+?", "a*", "a*?", "a??b", "x*?y",
+    "a{2,3}", "a{2,3}?", "a{2,}", "(a|ab)(c|bcd)", "(ab|a)b*", "a*(ab)?", "^a", "b$", "^a|b$",
+    "^$", "[0-9]+", "[^ab]+", "[a-c]x", "a.b", ".*", "(ab)+c", "colou?r", "\\d+\\s*\\w",
+    "(a|b)*abb", "TODO", "todo:?\\s", "[A-Z][a-z]+", "(a+b)|x",
+};
+
+// Spans of every match, found the way the scanner walks a line: the next
+// search starts at the end of the last match, one further after an empty one.
+std::string spans(const Matcher& matcher, std::string_view text){
+    std::string out;
+    std::size_t from = 0;
+    MatchSpan span;
+    while(from <= text.size() && matcher.find(text, from, span)){
+        out += "[" + std::to_string(span.begin) + "," + std::to_string(span.end) + ")";
+        from = span.end > span.begin ? span.end : span.end + 1;
+    }
+    return out;
+}
+
+std::vector<std::string> sampleLines(){
+    std::vector<std::string> lines = {
+        "", "a", "ab", "abc", "abcd", "aab", "aaaa", "xxy", "foobar foo", "colour color colr",
+        "12 ab 345x", "TODO: fix", "todo later", "Hello World", "ba ab ba", "aabb abab",
+        std::string(2000, 'a') + "x", std::string(2000, 'a') + "b",
+    };
+    std::mt19937 rng(20241017);
+    const std::string alphabet = "abcxyAB01 :";
+    std::uniform_int_distribution<std::size_t> length(0, 12);
+    std::uniform_int_distribution<std::size_t> pick(0, alphabet.size() - 1);
+    for(int i = 0; i < 300; ++i){
+        std::string line;
+        for(std::size_t n = length(rng); n > 0; --n) line.push_back(alphabet[pick(rng)]);
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+}
+
+int main(){
+    const std::vector<std::string> lines = sampleLines();
+    std::size_t compiled = 0;
+    for(bool icase : {true, false}){
+        for(const char *pattern : PATTERNS){
+            auto [dfa, err] = compileDfaMatcher(pattern, icase);
+            if(err == RegexError::UnsupportedSyntax) continue;
+            CHECK_EQ(static_cast<int>(err), static_cast<int>(RegexError::Ok), std::string("compile ") + pattern);
+            if(!dfa) continue;
+            ++compiled;
+
+            auto flags = icase ? std::regex::ECMAScript | std::regex::icase : std::regex::ECMAScript;
+            StdRegexMatcher reference(std::regex(pattern, flags));
+            for(const auto &line : lines){
+                std::string what = std::string(pattern) + (icase ? " (icase)" : "") + " on \"" + line + "\"";
+                CHECK_EQ(dfa->search(line), reference.search(line), "search " + what);
+                CHECK_EQ(spans(*dfa, line), spans(reference, line), "find " + what);
+            }
+        }
+    }
+    // Every pattern above is one the DFA is meant to handle.
+    CHECK_EQ(compiled, 2 * std::size(PATTERNS), "patterns compiled");
+    return testResult("dfa_matcher_test");
+}
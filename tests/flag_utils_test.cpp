@@ -0,0 +1,125 @@
+#include <string>
+#include "check.hpp"
+#include "flag_utils.hpp"
+
+// Table tests for parseFlags: each command line either applies cleanly or
+// stops with the expected error.
+namespace{
+
+struct FlagCase{
+    const char *params;
+    FlagError expected;
+};
+
+const FlagCase SEARCH_CASES[] = {
+    {"", FlagError::Ok},
+    {"   ", FlagError::Ok},
+    {"--max-depth=3 --threads=1 --index", FlagError::Ok},
+    {"--md=0 --mfs=512KB --mgm=10", FlagError::Ok},
+    {"--format=jsonl", FlagError::Ok},
+    {"--context=2", FlagError::Ok},
+    {"--type=cpp,py --glob=*.txt --exclude=build", FlagError::Ok},
+    {"max-depth=3", FlagError::InvalidFlag},
+    {"-md=3", FlagError::InvalidFlag},
+    {"--", FlagError::InvalidFlag},
+    {"--=3", FlagError::InvalidFlag},
+    {"--max-depth=", FlagError::EmptyParams},
+    {"--max-depth", FlagError::NoValue},
+    {"--max-depth=abc", FlagError::InvalidValue},
+    {"--max-depth=-1", FlagError::InvalidValue},
+    {"--max-depth=3KB", FlagError::UnitNotAllowed},
+    {"--max-depth=2147483648", FlagError::InvalidValue},
+    {"--max-depth=99999999999999999999999", FlagError::InvalidValue},
+    {"--threads=0", FlagError::InvalidValue},
+    {"--threads=100000000", FlagError::InvalidValue},
+    {"--max-file-size=10", FlagError::NoUnit},
+    {"--max-file-size=10TB", FlagError::InvalidUnit},
+    {"--max-file-size=10kb", FlagError::InvalidUnit},
+    {"--max-file-size=18446744073709551615GB", FlagError::InvalidValue},
+    {"--index=yes", FlagError::InvalidValue},
+    {"--format=xml", FlagError::InvalidValue},
+    {"--type=cobol", FlagError::InvalidValue},
+    {"--no-such-flag", FlagError::UnknownFlag},
+    {"--sort", FlagError::UnknownFlag},
+    {"--max-depth=3 --bogus", FlagError::UnknownFlag},
+};
+
+const FlagCase READ_CASES[] = {
+    {"--from=1 --count=5", FlagError::Ok},
+    {"--tail=10", FlagError::Ok},
+    {"--from=0", FlagError::InvalidValue},
+    {"--count=0", FlagError::InvalidValue},
+    {"--threads=2", FlagError::UnknownFlag},
+};
+
+const FlagCase DELETE_CASES[] = {
+    {"--match=\\.tmp$ --dry-run --no-ignore", FlagError::Ok},
+    {"--dry-run=1", FlagError::InvalidValue},
+    {"--match", FlagError::NoValue},
+};
+
+std::string errorName(FlagError err){
+    switch(err){
+        case FlagError::Ok: return "Ok";
+        case FlagError::EmptyFlag: return "EmptyFlag";
+        case FlagError::InvalidFlag: return "InvalidFlag";
+        case FlagError::NoValue: return "NoValue";
+        case FlagError::NoUnit: return "NoUnit";
+        case FlagError::EmptyParams: return "EmptyParams";
+        case FlagError::InvalidValue: return "InvalidValue";
+        case FlagError::InvalidUnit: return "InvalidUnit";
+        case FlagError::UnitNotAllowed: return "UnitNotAllowed";
+        case FlagError::UnknownFlag: return "UnknownFlag";
+    }
+    return "?";
+}
+
+template<typename Config, std::size_t N>
+void checkFlags(const FlagTable<Config>& table, const FlagCase (&cases)[N]){
+    for(const auto &c : cases){
+        Config config;
+        CHECK_EQ(errorName(parseFlags(c.params, table, config)), errorName(c.expected), std::string("parseFlags(\"") + c.params + "\")");
+    }
+}
+
+}
+
+int main(){
+    checkFlags(SEARCH_FLAGS, SEARCH_CASES);
+    checkFlags(READ_FLAGS, READ_CASES);
+    checkFlags(DELETE_FLAGS, DELETE_CASES);
+
+    // Values reach their fields.
+    SearchConfig search;
+    CHECK(parseFlags("--md=4 --mfs=2MB --th=1 --no-ignore --C=3", SEARCH_FLAGS, search) == FlagError::Ok);
+    CHECK_EQ(search.maxDepth, 4, "max-depth");
+    CHECK_EQ(search.maxFileSize, 2 * MB, "max-file-size");
+    CHECK_EQ(search.threads, 1u, "threads");
+    CHECK(!search.useIgnore);
+    CHECK_EQ(search.beforeContext, 3u, "before-context");
+    CHECK_EQ(search.afterContext, 3u, "after-context");
+
+    SearchConfig partial;
+    CHECK(parseFlags("--B=2 --A=5", SEARCH_FLAGS, partial) == FlagError::Ok);
+    CHECK_EQ(partial.beforeContext, 2u, "before-context");
+    CHECK_EQ(partial.afterContext, 5u, "after-context");
+
+    // grep-style context flags at the end of a query.
+    const char *shorthand[][3] = {
+        {"TODO -C 1", "TODO", "--C=1"},
+        {"TODO  -B 2 -A3 ", "TODO", "--B=2 --A=3"},
+        {"a b -C 10", "a b", "--C=10"},
+        {"-C 1", "-C 1", ""},
+        {"x-C 1", "x-C 1", ""},
+        {"TODO -D 1", "TODO -D 1", ""},
+        {"TODO -C", "TODO -C", ""},
+        {"v 12", "v 12", ""},
+    };
+    for(const auto &c : shorthand){
+        std::string_view query = c[0];
+        std::string flags = takeContextShorthand(query);
+        CHECK_EQ(std::string(query), std::string(c[1]), std::string("query of \"") + c[0] + "\"");
+        CHECK_EQ(flags, std::string(c[2]), std::string("flags of \"") + c[0] + "\"");
+    }
+    return testResult("flag_utils_test");
+}
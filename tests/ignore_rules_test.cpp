@@ -0,0 +1,103 @@
+#include <initializer_list>
+#include <string>
+#include "check.hpp"
+#include "ignore_rules.hpp"
+
+// Table tests for IgnoreRules::match.
+namespace{
+
+struct IgnoreCase{
+    const char *rel;
+    bool isDir;
+    IgnoreVerdict verdict;
+};
+
+std::string name(const char* rel){
+    std::string path(rel);
+    std::size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+std::string verdictName(IgnoreVerdict verdict){
+    switch(verdict){
+        case IgnoreVerdict::None: return "None";
+        case IgnoreVerdict::Ignore: return "Ignore";
+        case IgnoreVerdict::Include: return "Include";
+    }
+    return "?";
+}
+
+void checkRules(std::initializer_list<const char*> lines, std::initializer_list<IgnoreCase> cases){
+    IgnoreRules rules;
+    std::string label;
+    for(const char *line : lines){
+        rules.add(line);
+        label += std::string(label.empty() ? "" : " | ") + line;
+    }
+    for(const auto &c : cases){
+        std::string what = "rules \"" + label + "\" on " + c.rel + (c.isDir ? "/" : "");
+        CHECK_EQ(verdictName(rules.match(c.rel, name(c.rel), c.isDir)), verdictName(c.verdict), what);
+    }
+}
+
+}
+
+int main(){
+    using V = IgnoreVerdict;
+    // A name without a slash matches at any depth, files and directories alike.
+    checkRules({"build", "*.log"}, {
+        {"build", true, V::Ignore},
+        {"src/build", false, V::Ignore},
+        {"a/b/debug.log", false, V::Ignore},
+        {"debug.log.txt", false, V::None},
+        {"builder", true, V::None},
+    });
+    // A trailing slash matches directories only.
+    checkRules({"out/", "*.tmp/"}, {
+        {"out", true, V::Ignore},
+        {"out", false, V::None},
+        {"x/out", true, V::Ignore},
+        {"cache.tmp", true, V::Ignore},
+        {"cache.tmp", false, V::None},
+    });
+    // A leading or inner slash anchors the rule to the ignore file's directory.
+    checkRules({"/todo.txt", "doc/*.html", "/bin/"}, {
+        {"todo.txt", false, V::Ignore},
+        {"sub/todo.txt", false, V::None},
+        {"doc/index.html", false, V::Ignore},
+        {"sub/doc/index.html", false, V::None},
+        {"doc/api/index.html", false, V::None},
+        {"bin", true, V::Ignore},
+        {"tools/bin", true, V::None},
+    });
+    // "**/" matches at any depth, including none.
+    checkRules({"**/logs", "**/cache/*.bin", "src/**/gen"}, {
+        {"logs", true, V::Ignore},
+        {"a/b/logs", true, V::Ignore},
+        {"cache/a.bin", false, V::Ignore},
+        {"x/y/cache/a.bin", false, V::Ignore},
+        {"src/gen", true, V::Ignore},
+        {"src/a/b/gen", true, V::Ignore},
+        {"lib/gen", true, V::None},
+    });
+    // Negation re-includes, and the last matching rule wins.
+    checkRules({"*.log", "!keep.log", "keep.log.d/", "!/build/", "build/"}, {
+        {"debug.log", false, V::Ignore},
+        {"keep.log", false, V::Include},
+        {"sub/keep.log", false, V::Include},
+        {"keep.log.d", true, V::Ignore},
+        {"build", true, V::Ignore},
+    });
+    checkRules({"build/", "!/build/"}, {
+        {"build", true, V::Include},
+        {"sub/build", true, V::Ignore},
+    });
+    // Comments, blank lines and escapes.
+    checkRules({"# comment", "", "\\#hash", "\\!bang", "trailing   "}, {
+        {"# comment", false, V::None},
+        {"#hash", false, V::Ignore},
+        {"!bang", false, V::Ignore},
+        {"trailing", false, V::Ignore},
+    });
+    return testResult("ignore_rules_test");
+}
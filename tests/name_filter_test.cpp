@@ -0,0 +1,89 @@
+#include <string>
+#include "check.hpp"
+#include "name_filter.hpp"
+
+// Table tests for globMatch and the NameFilter built from --type, --glob
+// and --exclude.
+namespace{
+
+struct GlobCase{
+    const char *pattern;
+    const char *text;
+    bool matches;
+};
+
+const GlobCase GLOB_CASES[] = {
+    {"*.cpp", "main.cpp", true},
+    {"*.cpp", "main.hpp", false},
+    {"*.cpp", "src/main.cpp", false},
+    {"?.h", "a.h", true},
+    {"?.h", "ab.h", false},
+    {"?", "/", false},
+    {"a*", "a", true},
+    {"src/*.cpp", "src/main.cpp", true},
+    {"src/*.cpp", "src/sub/main.cpp", false},
+    {"**/main.cpp", "main.cpp", true},
+    {"**/main.cpp", "src/sub/main.cpp", true},
+    {"**/main.cpp", "src/xmain.cpp", false},
+    {"src/**/*.h", "src/a.h", true},
+    {"src/**/*.h", "src/x/y/a.h", true},
+    {"src/**", "src/x/y", true},
+    {"**", "any/path/at/all", true},
+    {"[abc].txt", "b.txt", true},
+    {"[abc].txt", "d.txt", false},
+    {"[!abc].txt", "d.txt", true},
+    {"[!abc].txt", "a.txt", false},
+    {"[a-c]x", "bx", true},
+    {"[a-c]x", "dx", false},
+    {"\\*.txt", "*.txt", true},
+    {"\\*.txt", "a.txt", false},
+    {"[", "[", true},
+    {"", "", true},
+    {"", "a", false},
+};
+
+struct FilterCase{
+    const char *path;
+    bool accepted;
+};
+
+}
+
+int main(){
+    for(const auto &c : GLOB_CASES){
+        CHECK_EQ(globMatch(c.pattern, c.text), c.matches, std::string("globMatch(\"") + c.pattern + "\", \"" + c.text + "\")");
+    }
+
+    // Every kind of pattern: an extension, an exact name, a literal suffix
+    // and a glob, with an excluded directory.
+    NameFilter filter;
+    CHECK(filter.addTypes("py") == FlagError::Ok);
+    filter.addGlob("Makefile", false);
+    filter.addGlob("*_test.cpp", false);
+    filter.addGlob("v[0-9]*.txt", false);
+    filter.addGlob("vendor", true);
+    filter.addGlob("*.pyc", true);
+    CHECK(filter.addTypes("nosuchtype") == FlagError::InvalidValue);
+
+    const FilterCase cases[] = {
+        {"main.py", true},
+        {"src/tools/gen.py", true},
+        {"Makefile", true},
+        {"sub/Makefile", true},
+        {"makefile", false},
+        {"io_test.cpp", true},
+        {"io.cpp", false},
+        {"v2notes.txt", true},
+        {"notes.txt", false},
+        {"vendor/lib.py", false},
+        {"src/vendor/lib.py", false},
+        {"vendored/lib.py", true},
+        {"cache.pyc", false},
+    };
+    for(const auto &c : cases){
+        CHECK_EQ(filter.acceptsPath(c.path), c.accepted, std::string("acceptsPath(\"") + c.path + "\")");
+    }
+    CHECK(!filter.acceptsDirectory("vendor"));
+    CHECK(filter.acceptsDirectory("src"));
+    return testResult("name_filter_test");
+}
@@ -0,0 +1,42 @@
+#include <memory>
+#include <regex>
+#include <string>
+#include "check.hpp"
+#include "pattern_cache.hpp"
+
+// Case-insensitive patterns share a cache entry only when they compile to
+// the same matcher.
+namespace{
+
+MatcherPtr matcherFor(const std::string& pattern){
+    return std::make_shared<StdRegexMatcher>(std::regex(pattern, std::regex::ECMAScript | std::regex::icase));
+}
+
+bool shareEntry(const std::string& stored, const std::string& looked){
+    PatternCache cache(8);
+    MatcherPtr matcher = cache.insert(stored, true, matcherFor(stored));
+    return cache.find(looked, true) == matcher;
+}
+
+}
+
+int main(){
+    CHECK(shareEntry("TODO", "todo"));
+    CHECK(shareEntry("Foo(Bar)?", "foo(bar)?"));
+    // Escapes and bracket expressions keep their case.
+    CHECK(!shareEntry("\\D+", "\\d+"));
+    CHECK(!shareEntry("[A-z]", "[a-z]"));
+    CHECK(!shareEntry("x[A-Z_]y", "x[a-z_]y"));
+    CHECK(!shareEntry("[[:alpha:]A-z]", "[[:alpha:]a-z]"));
+    // Letters after a bracket expression fold again.
+    CHECK(shareEntry("[0-9]ABC", "[0-9]abc"));
+    CHECK(shareEntry("[[:digit:]]X", "[[:digit:]]x"));
+    CHECK(shareEntry("[\\]]A", "[\\]]a"));
+
+    PatternCache cache(8);
+    MatcherPtr sensitive = cache.insert("abc", false, matcherFor("abc"));
+    CHECK(cache.find("ABC", false) == nullptr);
+    CHECK(cache.find("abc", true) == nullptr);
+    CHECK(cache.find("abc", false) == sensitive);
+    return testResult("pattern_cache_test");
+}
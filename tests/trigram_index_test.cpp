@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "literal_scan.hpp"
+#include "trigram_index.hpp"
+
+// Builds an index of a scratch tree, saves and loads it back, and checks
+// that the loaded copy is the built one and answers the same queries.
+namespace{
+
+void writeFile(const std::filesystem::path& path, const std::string& content){
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path, std::ios::binary) << content;
+}
+
+std::vector<std::string> candidateNames(const TrigramIndex& index, const std::string& literal){
+    SearchConfig config;
+    std::vector<std::string> names;
+    for(const auto &path : indexCandidates(index, literalTrigrams({literal}), config)){
+        names.push_back(path.lexically_relative(index.root).generic_string());
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+std::string joined(const std::vector<std::string>& names){
+    std::string out;
+    for(const auto &name : names) out += (out.empty() ? "" : " ") + name;
+    return out;
+}
+
+}
+
+int main(){
+    auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    std::filesystem::path root = std::filesystem::temp_directory_path() / ("filecli-index-test-" + std::to_string(stamp));
+    writeFile(root / "a.txt", "the quick brown fox\n");
+    writeFile(root / "src/b.cpp", "int main(){ return quick(); }\n");
+    writeFile(root / "src/deep/c.md", "Nothing to see here\n");
+    writeFile(root / "blob.bin", std::string("\0\1\2quick\0", 9));
+    writeFile(root / "node_modules/pkg/d.js", "quick\n");
+    writeFile(root / ".git/HEAD", "ref: refs/heads/quick\n");
+    writeFile(root / ".gitignore", "node_modules/\n");
+
+    auto [built, buildErr] = buildIndex(root);
+    CHECK(buildErr == FileError::Ok);
+    CHECK(saveIndex(built) == FileError::Ok);
+    auto [loaded, loadErr] = loadIndex(root);
+    CHECK(loadErr == FileError::Ok);
+
+    CHECK_EQ(loaded.root.string(), built.root.string(), "root");
+    CHECK_EQ(loaded.files.size(), built.files.size(), "file count");
+    for(std::size_t i = 0; i < std::min(loaded.files.size(), built.files.size()); ++i){
+        const IndexedFile &a = loaded.files[i], &b = built.files[i];
+        CHECK_EQ(a.path, b.path, "file path");
+        CHECK(a.mtime == b.mtime && a.size == b.size && a.binary == b.binary);
+    }
+    CHECK_EQ(loaded.dirs.size(), built.dirs.size(), "dir count");
+    for(std::size_t i = 0; i < std::min(loaded.dirs.size(), built.dirs.size()); ++i){
+        CHECK_EQ(loaded.dirs[i].path, built.dirs[i].path, "dir path");
+        CHECK(loaded.dirs[i].mtime == built.dirs[i].mtime);
+    }
+    CHECK(loaded.postings == built.postings);
+
+    // Binary files, ignored directories and .git stay out of the candidates.
+    CHECK_EQ(joined(candidateNames(loaded, "quick")), std::string("a.txt src/b.cpp"), "candidates for quick");
+    CHECK_EQ(joined(candidateNames(loaded, "see here")), std::string("src/deep/c.md"), "candidates for see here");
+    CHECK_EQ(joined(candidateNames(loaded, "absent")), std::string(), "candidates for absent");
+    CHECK_EQ(joined(candidateNames(loaded, "quick")), joined(candidateNames(built, "quick")), "built and loaded agree");
+
+    // A truncated index file is rejected rather than half loaded.
+    std::filesystem::resize_file(root / INDEX_FILE_NAME, 12);
+    CHECK(loadIndex(root).second == FileError::ReadFailure);
+
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    return testResult("trigram_index_test");
+}